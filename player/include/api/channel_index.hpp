@@ -0,0 +1,65 @@
+#pragma once
+
+#include "api/twitch.hpp"
+
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+
+#include <optional>
+#include <vector>
+
+// In-memory index of every channel the application has come across, for
+// instant search-as-you-type without any round trip.
+// Names are kept sorted for prefix lookups and indexed by trigrams for
+// fuzzy matches, which keeps queries well under a millisecond for the few
+// thousand channels a session typically sees (the time each one takes is
+// recorded in the API metrics)
+class ChannelIndex {
+public:
+    // By decreasing relevance when ranking otherwise equivalent matches
+    enum class Source {
+        Followed,
+        Watched,
+        Monitored,
+        Directory,
+    };
+
+    struct Match {
+        QString name;
+        double score;
+        // Only for channels seen live recently
+        std::optional<StreamData> stream;
+    };
+
+    void insert(const QString &, Source);
+    void insert(const StreamData &, Source);
+
+    QList<Match> search(const QString &, int) const;
+
+private:
+    struct Entry {
+        QString name, key;
+        QString display_key;
+        int source_rank;
+        std::optional<StreamData> stream;
+        QElapsedTimer seen_live;
+    };
+
+    std::vector<Entry> _entries;
+    QHash<QString, int> _ids;
+    // Every trigram of the name and the display name of an entry, once
+    QHash<quint64, std::vector<int>> _trigrams;
+
+    // Sorted by key, rebuilt lazily after insertions
+    mutable std::vector<int> _sorted_ids;
+    mutable bool _sorted_dirty = false;
+
+    // An empty display name leaves the one already known as is
+    int upsert(const QString &, const QString &, Source);
+    void index_trigrams(int, const QSet<quint64> &);
+    void unindex_trigrams(int, const QSet<quint64> &);
+
+    void ensure_sorted() const;
+    double score(const Entry &, const QString &, int) const;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QPixmap>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <QtPromise>
+
+#include "prelude/promise.hpp"
+
+#include <optional>
+
+class ThumbnailStore;
+
+// Process-wide image loader shared by every stream card and overlay.
+// Downloads go through the shared network service, decoding happens on a
+// worker pool at the requested display size, and decoded pixmaps are kept in
+// an LRU cache keyed by URL and size. Every decoded image is also written to
+// an on-disk thumbnail store so that the next session can paint instantly
+class ImageService: public QObject {
+public:
+    static ImageService &instance();
+
+    using image_response_t = QtPromise::QPromise<QPixmap>;
+
+    // Resolves with a pixmap no older than a few minutes, downloading it again
+    // if needed. A shared download is only aborted once every caller
+    // waiting for it has cancelled
+    image_response_t fetch(const QString &, QSize, CancelToken = { });
+    // Whatever is available right away (memory, then disk), possibly stale
+    std::optional<QPixmap> cached(const QString &, QSize);
+
+private:
+    ImageService(QObject * = nullptr);
+
+    struct CachedPixmap {
+        QPixmap pixmap;
+        QElapsedTimer age;
+    };
+
+    ThumbnailStore *store_for(QSize);
+
+    QThreadPool _decode_pool;
+
+    QCache<QString, CachedPixmap> _pixmaps;
+    QHash<QString, ThumbnailStore *> _stores;
+    struct InFlight {
+        image_response_t response;
+        CancelToken download_token;
+        int waiters;
+    };
+
+    QHash<QString, InFlight> _in_flight;
+
+    void add_waiter(const QString &, CancelToken);
+};
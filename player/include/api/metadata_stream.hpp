@@ -0,0 +1,37 @@
+#pragma once
+
+#include "api/twitchd.hpp"
+
+#include <QObject>
+#include <QPointer>
+
+class QNetworkReply;
+class QTimer;
+
+// Subscription to the segment metadata that twitchd pushes (as server-sent
+// events) for the sink identified by a meta key.
+// The subscription is re-established with a backoff whenever it drops, which
+// also covers subscribing before the daemon started serving the stream
+class MetadataStream: public QObject {
+    Q_OBJECT
+
+public:
+    MetadataStream(QObject * = nullptr);
+    ~MetadataStream();
+
+    void open(QString, QString, QString);
+    void close();
+
+signals:
+    void metadata_received(SegmentMetadata);
+
+private:
+    QUrl _url;
+    QPointer<QNetworkReply> _reply;
+    QByteArray _buffer;
+
+    QTimer *_reconnect_timer;
+
+    void connect_stream();
+    void consume_events();
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "prelude/histogram.hpp"
+
+#include <QObject>
+#include <QMap>
+#include <QDateTime>
+#include <QJsonObject>
+
+// Process-wide record of how every API endpoint behaves: timings as
+// histograms, transferred bytes and the outcome of each call.
+// Network timings are in milliseconds, parse times in microseconds.
+// Playback health events (stalls detected in panes) are kept alongside, to
+// be diagnosed in the same place
+class ApiMetrics: public QObject {
+    Q_OBJECT
+
+public:
+    static ApiMetrics &instance();
+
+    struct Exchange {
+        // Spent waiting for a slot in the network service
+        qint64 queue_ms = 0;
+        // Only set when a new encrypted connection had to be established
+        qint64 connect_ms = -1;
+        qint64 ttfb_ms = -1;
+        qint64 total_ms = 0;
+        qint64 bytes = 0;
+        QString outcome;
+        // Whether a response came back: the timings of anything else
+        // (breaker rejections, timeouts, cancelled or superseded attempts)
+        // would skew the histograms hedging is based on, only its outcome
+        // is counted
+        bool completed = false;
+    };
+
+    struct EndpointMetrics {
+        Histogram queue, connect, ttfb, total, parse;
+        quint64 bytes = 0;
+        quint64 hedges_sent = 0, hedges_won = 0;
+        QMap<QString, quint64> outcomes;
+    };
+
+    // From the start of the process until the first stream picker has
+    // streams to show, with or without connection warm-up, and until the
+    // daemon can serve streams and libvlc is initialized
+    struct Startup {
+        qint64 time_to_first_picker_ms = -1;
+        bool warmed_up = false;
+        qint64 time_to_daemon_ready_ms = -1;
+        qint64 time_to_vlc_ready_ms = -1;
+    };
+
+    void record_exchange(const QString &, const Exchange &);
+    void record_parse(const QString &, qint64 parse_us);
+    void record_hedge_sent(const QString &);
+    void record_hedge_won(const QString &);
+    void record_startup(qint64 time_to_first_picker_ms, bool warmed_up);
+    void record_daemon_ready(qint64 time_to_daemon_ready_ms);
+    void record_vlc_ready(qint64 time_to_vlc_ready_ms);
+
+    // PubSub connections lost, and how long it took until their topics
+    // were listened to again
+    struct PubSub {
+        Histogram resubscribe;
+        quint64 reconnects = 0;
+        quint64 pong_timeouts = 0;
+    };
+
+    void record_pubsub_reconnect(bool pong_timeout);
+    void record_pubsub_resubscribe(qint64 ms);
+
+    // How late a periodic timer of the GUI thread fires, in milliseconds:
+    // whatever blocks the event loop (parsing a large listing on the GUI
+    // thread, for one) shows up as lag.
+    // Local channel searches run on every keystroke, in microseconds: they
+    // are meant to stay under a millisecond
+    struct GuiLoop {
+        Histogram lag;
+        Histogram channel_search;
+    };
+
+    void record_channel_search(qint64 us);
+
+    struct PlaybackEvent {
+        QDateTime at;
+        QString channel;
+        QString reason;
+    };
+
+    void record_playback_event(const QString &, const QString &);
+    const QList<PlaybackEvent> & playback_events() const;
+
+    const QMap<QString, EndpointMetrics> & endpoints() const;
+    const Startup & startup() const;
+    const PubSub & pubsub() const;
+    const GuiLoop & gui_loop() const;
+
+    QJsonObject to_json() const;
+
+signals:
+    void updated();
+
+private:
+    ApiMetrics(QObject * = nullptr);
+
+    QMap<QString, EndpointMetrics> _endpoints;
+    Startup _startup;
+    PubSub _pubsub;
+    GuiLoop _gui_loop;
+    // Most recent last
+    QList<PlaybackEvent> _playback_events;
+};
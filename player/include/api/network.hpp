@@ -0,0 +1,146 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QQueue>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QElapsedTimer>
+
+#include <QtPromise>
+
+#include "prelude/promise.hpp"
+
+#include <array>
+#include <functional>
+
+class QNetworkAccessManager;
+
+// Name under which a request is accounted in the API metrics, defaults to
+// the host of the request
+constexpr auto ENDPOINT_ATTRIBUTE = QNetworkRequest::User;
+
+// Requests of a higher class leave the queue first. Background requests are
+// also capped process-wide, so that a picker full of thumbnails cannot take
+// the bandwidth away from a stream starting to play
+enum class Priority {
+    // Something the user waits for right now (stream start, token refresh)
+    Interactive,
+    Default,
+    // Images and other cosmetic downloads
+    Background,
+};
+
+constexpr auto PRIORITY_COUNT = 3;
+
+// Holds a Priority as an int, defaults to Priority::Default
+constexpr auto PRIORITY_ATTRIBUTE = static_cast<QNetworkRequest::Attribute>(QNetworkRequest::User + 1);
+
+// For idempotent GETs: when the response is later than the usual p95 of the
+// endpoint, the same request is sent again and the first answer wins
+constexpr auto HEDGE_ATTRIBUTE = static_cast<QNetworkRequest::Attribute>(QNetworkRequest::User + 2);
+
+// For probes whose whole point is to find out whether a host is back (daemon
+// readiness): they are sent even while the breaker of the host is open, and
+// their outcome does not count towards it
+constexpr auto BYPASS_BREAKER_ATTRIBUTE = static_cast<QNetworkRequest::Attribute>(QNetworkRequest::User + 3);
+
+// Process-wide HTTP stack: every client goes through a single network manager
+// so that connections (and TLS sessions) are kept alive and shared, and
+// HTTP/2 can multiplex requests to the same host.
+// The number of requests in flight per host is bounded (far less so for
+// hosts that speak HTTP/2), extra ones wait in a FIFO queue per priority
+// class until a slot frees up.
+// Each host also has a circuit breaker: after a few consecutive failures of
+// the host itself, requests to it fail right away for a backoff period, then
+// a single probe decides whether it is back
+class NetworkService: public QObject {
+    Q_OBJECT
+
+public:
+    static NetworkService &instance();
+
+    enum class BreakerState {
+        Closed,
+        Open,
+        HalfOpen,
+    };
+
+    using response_t = QtPromise::QPromise<QByteArray>;
+
+    // Resolves with the response body, rejects with a
+    // QNetworkReply::NetworkError (TimeoutError past the deadline of the
+    // priority class, TemporaryNetworkFailureError while the breaker of
+    // the host is open) or a CancelError
+    response_t fetch(QNetworkRequest, const QByteArray &verb,
+                     const QByteArray &body = { }, CancelToken = { });
+
+    // Long-lived GET whose body is consumed as it arrives (event streams).
+    // It bypasses the per-host queue so that it never holds a slot forever,
+    // and goes through a network manager of its own: Qt only opens 6
+    // HTTP/1.1 connections per host, a few panes streaming from the daemon
+    // would otherwise leave none for its other requests.
+    // The caller owns the reply
+    QNetworkReply *open_stream(QNetworkRequest);
+
+    // Connects to the hosts of these URLs ahead of their first request, so
+    // that it does not pay for the DNS resolution and the TCP and TLS
+    // handshakes. The connections are established in the background
+    void warm_up(const QList<QUrl> &);
+
+    struct HostStats {
+        int requests = 0;
+        // Only observable for encrypted connections: reuse is unknown for
+        // hosts that were never requested over HTTPS
+        bool encrypted = false;
+        int connections_opened = 0;
+        int http2_requests = 0;
+        int in_flight = 0;
+        int queued = 0;
+        bool warmed_up = false;
+        BreakerState breaker = BreakerState::Closed;
+        int consecutive_failures = 0;
+    };
+
+    QHash<QString, HostStats> stats() const;
+
+    // How long requests to the host keep failing fast, 0 if they go through
+    qint64 retry_in_ms(const QString &) const;
+
+signals:
+    void breaker_changed(QString, NetworkService::BreakerState);
+
+private:
+    NetworkService(QObject * = nullptr);
+
+    // Returns false when the request was dropped before being sent
+    using Dispatch = std::function<bool ()>;
+
+    struct HostPool {
+        std::array<QQueue<Dispatch>, PRIORITY_COUNT> queues;
+        HostStats stats;
+
+        QElapsedTimer breaker_opened;
+        int backoff_ms = 0;
+        bool probing = false;
+
+        // Once a response came over HTTP/2, the per-host cap is lifted
+        bool http2 = false;
+    };
+
+    QNetworkAccessManager *_http_client;
+    QNetworkAccessManager *_stream_client;
+    QHash<QString, HostPool> _hosts;
+    // Across every host
+    std::array<int, PRIORITY_COUNT> _class_in_flight = { };
+
+    // `probe` is set when the request admitted is the probe of a half-open
+    // breaker, which has to be passed back to `report`
+    bool admit(const QString &, bool &probe);
+    void report(const QString &, bool success, bool probe);
+    void set_breaker(const QString &, BreakerState);
+
+    void enqueue(const QString &, int, Dispatch);
+    void pump(const QString &);
+    void release(const QString &, int);
+};
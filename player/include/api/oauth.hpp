@@ -14,10 +14,13 @@ class OAuth: public QObject {
 public:
     OAuth(QObject * = nullptr);
 
+    // Refreshes the saved token if there is one, goes through the
+    // authorization in the browser otherwise
     QPromise<QString> query_token();
 
 signals:
     void token_ready(QString);
+    void token_failed();
 
 private:
     QTcpServer *_local_server;
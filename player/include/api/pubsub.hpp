@@ -1,9 +1,17 @@
 #pragma once
 
 #include <QJsonObject>
+#include <QHash>
+#include <QSet>
+#include <QUrl>
+#include <QElapsedTimer>
 
 #include <QtPromise>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 class QWebSocket;
 class QTimer;
 
@@ -12,28 +20,71 @@ struct PendingOrder {
     QtPromise::QPromiseReject<void> reject;
 };
 
+// A single connection to the PubSub edge, which caps the number of topics
+// each connection may listen to
+struct PubSubShard {
+    QWebSocket *ws;
+    QTimer *ping_timer;
+    // Armed by every PING: a connection that stays silent is dead
+    QTimer *pong_timer;
+    QTimer *reconnect_timer;
+
+    int reconnect_attempts = 0;
+    bool pong_timed_out = false;
+    // Since the connection was lost, until its topics are listened to again
+    QElapsedTimer down_since;
+
+    // Every topic the shard is responsible for, whether listened to yet or not
+    QSet<QString> topics;
+
+    // Orders waiting for the next batch
+    QStringList pending_listens;
+    QStringList pending_unlistens;
+};
+
+struct PendingBatch {
+    PubSubShard *shard;
+    QStringList topics;
+};
+
 class TwitchPubSub: public QObject {
     Q_OBJECT
 
 public:
     TwitchPubSub(QObject * = nullptr);
 
+    // Listens are counted per channel: the topic is only left once every
+    // listener has unlistened
     QtPromise::QPromise<void> listen_to_channel(QString);
     void unlisten_to_channel(QString);
 
 signals:
     void channel_went_live(QString);
     void channel_went_offline(QString);
+    // Pushed about every 30 seconds while a listened channel is live
+    void viewcount_changed(QString, int);
 
 private:
-    void send_message(QJsonObject);
-    void process_message(QJsonObject);
+    PubSubShard & shard_with_room();
+    void connect_shard(PubSubShard &);
+
+    void flush_orders();
+    void settle_topic(const QString &, const QString &error);
+
+    void send_message(PubSubShard &, QJsonObject);
+    void process_message(PubSubShard &, QJsonObject);
+
+    int reconnect_delay_ms(int attempts) const;
+
+    QUrl _url;
 
-    QWebSocket *_ws;
-    QTimer *_ping_timer;
+    std::vector<std::unique_ptr<PubSubShard>> _shards;
+    QHash<QString, PubSubShard *> _topic_shards;
 
-    QMap<QString, PendingOrder> _pending_orders;
+    // Listens are resolved per topic, orders are answered per batch
+    QHash<QString, PendingOrder> _pending_topics;
+    QMap<QString, PendingBatch> _pending_orders;
+    QHash<QString, int> _listeners;
 
-    QList<QJsonObject> _order_queue;
-    QList<QJsonObject> _orders_issued;
+    std::function<void ()> _schedule_flush;
 };
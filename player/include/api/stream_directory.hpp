@@ -0,0 +1,109 @@
+#pragma once
+
+#include "api/twitch.hpp"
+#include "api/channel_index.hpp"
+
+#include "prelude/promise.hpp"
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+
+// Application-wide cache of stream listings (top streams, followed streams
+// and searches), observed by every stream picker.
+// Listings are fetched one page at a time, on demand. A listing that is
+// older than its time-to-live keeps being served while its first page gets
+// fetched again, and is then replaced as a whole (`listing_reset`).
+// The followed listing is kept up to date in between with the PubSub
+// playback events of every followed channel, and viewer counts of the
+// channels on screen with the ones PubSub pushes
+class TwitchPubSub;
+
+class StreamDirectory: public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr auto PAGE_SIZE = 32;
+
+    StreamDirectory(TwitchPubSub &, QObject * = nullptr);
+    ~StreamDirectory();
+
+    static QString top_key();
+    static QString followed_key();
+    static QString search_key(const QString &);
+
+    // Pickers declare which listings they show, so that fetches nobody is
+    // waiting for anymore can be aborted and unused searches evicted
+    void watch(const QString &);
+    void unwatch(const QString &);
+
+    const QList<QList<StreamData>> & pages(const QString &);
+    // Fetches the page at the given index unless it is already there (or
+    // being fetched), or the listing is known to have no more pages
+    void request_page(const QString &, int);
+
+    // Every channel seen in a listing, followed, watched or monitored
+    ChannelIndex & channels();
+
+    // Viewer counts are pushed for the channels watched that way, REST
+    // polling is only a fallback for when the pushes stop.
+    // Capped watches (cards of a listing) are refused once enough channels
+    // are watched, returns whether the channel is watched: only then it has
+    // to be unwatched
+    bool watch_viewcount(const QString &, bool capped = false);
+    void unwatch_viewcount(const QString &);
+
+signals:
+    void page_ready(QString, int, QList<StreamData>);
+    void listing_reset(QString);
+    // In-place updates of a loaded listing, the position counts streams
+    // from the start of the listing
+    void stream_added(QString, int, StreamData);
+    void stream_removed(QString, QString);
+    void viewcount_changed(QString, int);
+
+private:
+    TwitchAPI _api;
+    TwitchPubSub &_pubsub;
+    ChannelIndex _channels;
+
+    struct Listing {
+        QList<QList<StreamData>> pages;
+        bool complete = false;
+        QElapsedTimer age;
+        CancelToken pending;
+        int watchers = 0;
+    };
+
+    QHash<QString, Listing> _listings;
+    // Least recently shown last
+    QStringList _search_history;
+
+    // Followed channels by name, listened to for playback events
+    QHash<QString, uint32_t> _followed_channels;
+
+    // Watchers by channel, and the channels listened to for viewer counts,
+    // which outlive their watchers for a bit
+    QHash<QString, int> _viewcount_watchers;
+    QSet<QString> _viewcount_listened;
+
+    void seed_channels();
+
+    void track_followed();
+    void collect_followed(uint32_t, int, QHash<QString, uint32_t>);
+    void update_followed(const QHash<QString, uint32_t> &);
+    void followed_went_live(const QString &, int = 0);
+    void reconcile_followed();
+
+    void insert_stream(const QString &, const StreamData &);
+    void remove_stream(const QString &, const QString &);
+    void update_viewcount(const QString &, int);
+
+    TwitchAPI::streams_response_t query(const QString &, Page, CancelToken);
+    int time_to_live(const QString &) const;
+
+    void revalidate(const QString &);
+    void fetch(const QString &, int);
+    void evict_searches();
+};
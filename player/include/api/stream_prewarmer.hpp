@@ -0,0 +1,43 @@
+#pragma once
+
+#include "api/twitch.hpp"
+#include "api/twitchd.hpp"
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+
+#include <optional>
+
+// Process-wide warm-up of channels that are likely to be opened next (the
+// ones a go-live notification was just shown for).
+// What opening a channel waits for is resolved in the background: the stream
+// index (which also gets the daemon to look the stream up), the stream
+// details and the channel logo. Only a few channels are warmed at once, and
+// what they resolved to is forgotten once the daemon's stream index cache
+// expires (or right away if it could not be resolved)
+class StreamPrewarmer: public QObject {
+public:
+    static StreamPrewarmer &instance();
+
+    void prewarm(const QString &);
+
+    std::optional<StreamIndex> stream_index(const QString &);
+    std::optional<StreamData> stream(const QString &);
+
+private:
+    StreamPrewarmer(QObject * = nullptr);
+
+    struct Prewarmed {
+        QElapsedTimer age;
+        std::optional<StreamIndex> index;
+        std::optional<StreamData> stream;
+    };
+
+    QHash<QString, Prewarmed> _prewarmed;
+
+    TwitchAPI _twitch;
+    TwitchdAPI _daemon;
+
+    void evict_expired();
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QObject>
+#include <QFile>
+#include <QLockFile>
+#include <QHash>
+#include <QVector>
+#include <QImage>
+
+#include <functional>
+#include <optional>
+
+// Persistent store of pre-scaled thumbnails, kept in a memory-mapped atlas
+// file made of fixed-size slots and described by a small index file.
+// Images are stored in the raster paint format so that reading one back
+// costs a single copy, without any decoding.
+// The atlas starts with a tag per slot identifying the URL its pixels are
+// from: the index is only saved once in a while, the tags are what a slot
+// is trusted on. A single process owns the atlas at a time, the others only
+// get the in-memory cache of the image service
+class ThumbnailStore: public QObject {
+public:
+    ThumbnailStore(const QString &, QSize, int, QObject * = nullptr);
+    ~ThumbnailStore();
+
+    std::optional<QImage> lookup(const QString &);
+    void store(const QString &, const QImage &);
+
+private:
+    struct Slot {
+        QString url;
+        qint32 width = 0, height = 0;
+        qint64 last_used = 0;
+    };
+
+    QSize _slot_size;
+    int _capacity;
+
+    QLockFile _lock;
+    QFile _atlas;
+    QString _index_path;
+    uchar *_mapped = nullptr;
+    // Both within the mapped atlas, 0 is the tag of a slot being written
+    quint64 *_tags = nullptr;
+    uchar *_pixels = nullptr;
+
+    QVector<Slot> _slots;
+    QHash<QString, int> _slot_by_url;
+
+    std::function<void ()> _schedule_index_save;
+
+    qint64 slot_bytes() const;
+    uchar *slot_data(int) const;
+    int pick_slot() const;
+
+    void open_atlas();
+    void load_index();
+    void save_index();
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+
+#include <QtPromise>
+
+#include <optional>
+
+class QTimer;
+
+// Process-wide owner of the OAuth tokens.
+// The access token is kept in memory and refreshed ahead of its expiry, so
+// that authenticated requests do not have to be refused first. Callers that
+// need a refresh at the same time share a single one
+class TokenManager: public QObject {
+    Q_OBJECT
+
+public:
+    static TokenManager &instance();
+
+    // Empty when not logged in
+    QString access_token() const;
+
+    // The current token unless it is about to expire, a refreshed one
+    // otherwise
+    QtPromise::QPromise<QString> valid_token();
+    // For when the API refused the current token
+    QtPromise::QPromise<QString> refresh();
+
+    // Forgets the current tokens and goes through the authorization in
+    // the browser
+    void login();
+
+signals:
+    void token_changed(QString);
+
+private:
+    TokenManager(QObject * = nullptr);
+
+    QString _access_token;
+    QDateTime _expires_at;
+
+    std::optional<QtPromise::QPromise<QString>> _refresh;
+    QTimer *_refresh_timer;
+
+    bool has_refresh_token() const;
+    void load();
+};
@@ -17,16 +17,27 @@ struct StreamData {
     QDateTime created_at;
 };
 
+struct Page {
+    int offset = 0;
+    int limit = 32;
+};
+
 struct TwitchAPI: APIClient {
     using streams_response_t = response_t<QList<StreamData>>;
 
-    streams_response_t stream_search(QString);
-    streams_response_t top_streams();
-    streams_response_t followed_streams(const QString &);
+    streams_response_t stream_search(QString, Page = { }, CancelToken = { });
+    streams_response_t top_streams(Page = { }, CancelToken = { });
+    streams_response_t followed_streams(const QString &, Page = { }, CancelToken = { });
 
     using stream_response_t = response_t<StreamData>;
     stream_response_t stream(uint32_t);
 
     using channels_response_t = response_t<QList<ChannelData>>;
     channels_response_t channel_search(const QString &);
+    // Channels followed by a user, live or not
+    channels_response_t followed_channels(uint32_t, Page = { }, CancelToken = { });
+
+    using user_response_t = response_t<ChannelData>;
+    // The user an OAuth token belongs to
+    user_response_t current_user(const QString &);
 };
@@ -32,20 +32,26 @@ struct SegmentMetadata {
     quint32 ingest_r, ingest_s;
     double stream_offset;
     quint64 transc_r, transc_s;
+    // Where the segment starts in the stream served to us, in seconds
+    double sink_offset;
 };
 
 struct TwitchdAPI: APIClient {
     using stream_index_response_t = response_t<StreamIndex>;
     stream_index_response_t stream_index(QString);
 
-    using metadata_response_t = response_t<SegmentMetadata>;
-    metadata_response_t metadata(QString, QString, QString);
-
     using daemon_version_response_t = response_t<QString>;
     daemon_version_response_t daemon_version();
 
     using daemon_quit_response_t = response_t<void>;
     daemon_quit_response_t daemon_quit();
 
-    static QString playback_url(QString, QString, QString);
+    // Where the daemon is reachable, without any path
+    static QUrl base_url();
+    // Resolved once the access token it carries is known to be valid
+    using playback_url_response_t = response_t<QString>;
+    static playback_url_response_t playback_url(QString, QString, QString);
+    static QUrl metadata_stream_url(QString, QString, QString);
+
+    static SegmentMetadata parse_metadata(const QByteArray &);
 };
@@ -23,6 +23,7 @@ namespace constants {
         namespace oauth {
             Constant ACCESS_TOKEN_KEY = "oauth/access-token";
             Constant REFRESH_TOKEN_KEY = "oauth/refresh-token";
+            Constant EXPIRES_AT_KEY = "oauth/expires-at";
         }
 
         namespace chat_renderer {
@@ -50,8 +51,9 @@ namespace constants {
         }
 
         namespace streams {
+            Constant GROUP_LAST_QUALITY = "streams/last_quality";
             Constant KEY_LAST_QUALITY_FOR = [](auto channel) {
-                return QString("streams/last_quality/%1").arg(channel);
+                return QString("%1/%2").arg(GROUP_LAST_QUALITY, channel);
             };
         }
 
@@ -104,9 +106,20 @@ namespace constants {
             Constant DEFAULT_PLAYER_MAX_SINK_BUFFER_SIZE = 10000000;
         }
 
+        namespace network {
+            Constant KEY_WARM_UP_CONNECTIONS = "network/warm_up_connections";
+            Constant DEFAULT_WARM_UP_CONNECTIONS = true;
+        }
+
         namespace notifications {
             Constant KEY_PUBSUB_CHANNELS = "notifications/pubsub_channels";
             Constant DEFAULT_PUBSUB_CHANNELS = QStringList();
+            // Pointing it to a local stand-in makes the reconnection logic
+            // testable without the real edge
+            Constant KEY_PUBSUB_URL = "notifications/pubsub_url";
+            Constant DEFAULT_PUBSUB_URL = "wss://pubsub-edge.twitch.tv";
+            Constant KEY_PREWARM_ON_GO_LIVE = "notifications/prewarm_on_go_live";
+            Constant DEFAULT_PREWARM_ON_GO_LIVE = true;
         }
 
         namespace shortcuts {
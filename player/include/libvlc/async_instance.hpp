@@ -0,0 +1,18 @@
+#pragma once
+
+#include "libvlc/bindings.hpp"
+
+#include <QtPromise>
+
+#include <memory>
+
+namespace libvlc {
+
+// Creating an instance scans the plugins, which can take hundreds of
+// milliseconds on a cold cache: it happens on a worker thread instead.
+// Resolves to nullptr when libvlc failed to initialize
+using AsyncInstance = QtPromise::QPromise<std::shared_ptr<Instance>>;
+
+AsyncInstance create_instance_async(std::vector<std::string>);
+
+}
@@ -5,6 +5,7 @@
 #include "prelude/c_wrapper.hpp"
 
 #include <functional>
+#include <optional>
 #include <vector>
 #include <string>
 
@@ -40,6 +41,11 @@ struct MediaPlayer: CWrapper<libvlc_media_player_t> {
     void set_volume(int);
     void set_position(float);
 
+    std::optional<MediaStats> media_stats();
+    // Writes the current frame to a PNG file, a dimension of 0 keeps the
+    // aspect ratio. Blocks until the next frame is rendered (or a timeout)
+    bool take_snapshot(const std::string &, unsigned, unsigned);
+
     bool video_filters_enabled();
     void enable_video_filters(bool);
 
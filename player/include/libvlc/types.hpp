@@ -62,6 +62,16 @@ struct LogEntry {
     std::string text;
 };
 
+// Cumulated since the media started
+struct MediaStats {
+    int decoded_video;
+    int displayed_pictures;
+    int lost_pictures;
+    int decoded_audio;
+    int played_audio_buffers;
+    int lost_audio_buffers;
+};
+
 struct AudioDevice {
     std::string id;
     std::string description;
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+#include <vector>
+#include <algorithm>
+
+// Log-linear histogram of non-negative integer samples (typically durations in
+// milliseconds), in the spirit of HdrHistogram: values below SUB_BUCKETS are
+// counted exactly, larger ones in buckets about 6% wide. Memory stays bounded
+// no matter how many samples are recorded
+class Histogram {
+public:
+    void record(qint64 value) {
+        value = std::max<qint64>(value, 0);
+
+        auto index = bucket_index(value);
+        if (index >= _counts.size())
+            _counts.resize(index + 1, 0);
+
+        _counts[index] += 1;
+        _count += 1;
+        _sum += value;
+        _max = std::max(_max, value);
+    }
+
+    void reset() {
+        _counts.clear();
+        _count = 0;
+        _sum = 0;
+        _max = 0;
+    }
+
+    quint64 count() const { return _count; }
+    qint64 max() const { return _max; }
+
+    double mean() const {
+        return _count ? static_cast<double>(_sum) / _count : 0.;
+    }
+
+    // `p` in [0, 100]
+    qint64 percentile(double p) const {
+        if (_count == 0)
+            return 0;
+
+        auto rank = static_cast<quint64>(p / 100. * _count + .5);
+        rank = std::clamp<quint64>(rank, 1, _count);
+
+        quint64 seen = 0;
+        for (size_t index = 0; index < _counts.size(); ++index) {
+            seen += _counts[index];
+            if (seen >= rank)
+                return std::min(bucket_value(index), _max);
+        }
+
+        return _max;
+    }
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr qint64 SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    std::vector<quint64> _counts;
+    quint64 _count = 0;
+    qint64 _sum = 0;
+    qint64 _max = 0;
+
+    static size_t bucket_index(qint64 value) {
+        if (value < SUB_BUCKETS)
+            return static_cast<size_t>(value);
+
+        auto msb = 63 - qCountLeadingZeroBits(static_cast<quint64>(value));
+        auto shift = msb - SUB_BUCKET_BITS;
+        auto sub_bucket = (value >> shift) - SUB_BUCKETS;
+
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + sub_bucket);
+    }
+
+    // Middle of the range covered by a bucket
+    static qint64 bucket_value(size_t index) {
+        if (index < static_cast<size_t>(SUB_BUCKETS))
+            return static_cast<qint64>(index);
+
+        auto shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+        auto sub_bucket = static_cast<qint64>(index % SUB_BUCKETS) + SUB_BUCKETS;
+
+        return (sub_bucket << shift) + ((qint64 { 1 } << shift) >> 1);
+    }
+};
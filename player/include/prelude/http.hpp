@@ -1,44 +1,80 @@
 #pragma once
 
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QCoreApplication>
+#include <QNetworkRequest>
+#include <QElapsedTimer>
+#include <QThreadPool>
 
+#include <QtConcurrent>
 #include <QtPromise>
 
-class APIClient {
-private:
-    QNetworkAccessManager _http_client;
-
-    auto send_request(const QNetworkRequest &request, const QByteArray &verb) {
-        using QtPromise::QPromise;
+#include <type_traits>
+#include <utility>
 
-        return QPromise<QByteArray>([=](auto& resolve, auto& reject) {
-            auto reply = _http_client.sendCustomRequest(request, verb);
+#include "api/network.hpp"
+#include "api/metrics.hpp"
+#include "prelude/promise.hpp"
 
-            QObject::connect(reply, &QNetworkReply::finished, [=]() {
-                auto error = reply->error();
+class APIClient {
+private:
+    static QThreadPool &parse_pool() {
+        static auto pool = [] {
+            auto pool = new QThreadPool(qApp);
+            pool->setMaxThreadCount(2);
+            return pool;
+        }();
 
-                if (error == QNetworkReply::NoError)
-                    resolve(reply->readAll());
-                else
-                    reject(error);
+        return *pool;
+    }
 
-                reply->deleteLater();
-            });
+    auto send_request(const QString &endpoint, QNetworkRequest request,
+                      const QByteArray &verb, CancelToken token)
+    {
+        request.setAttribute(ENDPOINT_ATTRIBUTE, endpoint);
 
-        });
+        return NetworkService::instance().fetch(request, verb, { }, token);
     }
 
 public:
-    auto get(const QNetworkRequest &request) {
-        return send_request(request, "GET");
+    auto get(const QString &endpoint, const QNetworkRequest &request,
+             CancelToken token = { })
+    {
+        return send_request(endpoint, request, "GET", token);
     }
 
-    auto post(const QNetworkRequest &request) {
-        return send_request(request, "POST");
+    auto post(const QString &endpoint, const QNetworkRequest &request,
+              CancelToken token = { })
+    {
+        return send_request(endpoint, request, "POST", token);
     }
 
 protected:
     template <class T>
     using response_t = QtPromise::QPromise<T>;
+
+    // Wraps a response parser so that it runs on a worker pool: the GUI
+    // thread only receives the parsed value. The time spent parsing (and
+    // thus no longer stalling the GUI) is accounted to `endpoint`
+    template <class Parser>
+    static auto offloaded_parser(const QString &endpoint, Parser parser) {
+        using Parsed = std::decay_t<std::invoke_result_t<Parser, const QByteArray &>>;
+        using TimedParse = std::pair<Parsed, qint64>;
+
+        auto timed_parse = [=](const QByteArray &raw) {
+            QElapsedTimer timer;
+            timer.start();
+
+            auto parsed = parser(raw);
+
+            return TimedParse { std::move(parsed), timer.nsecsElapsed() / 1000 };
+        };
+
+        return [=](const QByteArray &raw) {
+            return QtPromise::qPromise(QtConcurrent::run(&parse_pool(), timed_parse, raw))
+                .then([=](const TimedParse &timed_result) {
+                    ApiMetrics::instance().record_parse(endpoint, timed_result.second);
+                    return timed_result.first;
+                });
+        };
+    }
 };
@@ -2,22 +2,45 @@
 
 #include <memory>
 #include <future>
+#include <vector>
+#include <functional>
 
 #include <QtPromise>
 
 struct Cancellable {
     void cancel() {
+        if (_cancelled)
+            return;
+
         _cancelled = true;
+
+        auto hooks = std::move(_hooks);
+        for (auto & hook: hooks)
+            hook();
     }
 
     bool cancelled() const {
         return _cancelled;
     }
 
+    // Registers an action to run when the token gets cancelled.
+    // Used to propagate the cancellation to the underlying operation (e.g.
+    // aborting a network reply) instead of only discarding its result
+    template <class Hook>
+    void on_cancel(Hook && hook) {
+        if (_cancelled)
+            hook();
+        else
+            _hooks.emplace_back(std::forward<Hook>(hook));
+    }
+
 private:
     bool _cancelled = false;
+    std::vector<std::function<void ()>> _hooks;
 };
 
+using CancelToken = std::shared_ptr<Cancellable>;
+
 struct CancelError: std::future_error {
     CancelError(): std::future_error { std::future_errc::broken_promise } { }
 };
@@ -33,5 +56,3 @@ auto make_cancellable(QtPromise::QPromise<T> promise) {
 
     return std::make_pair(cancel_token, tapped_promise);
 }
-
-using CancelToken = std::shared_ptr<Cancellable>;
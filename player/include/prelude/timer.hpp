@@ -16,3 +16,15 @@ void delayed(QObject *parent, int ms, Slot && slot) {
     timer->setSingleShot(true);
     timer->start(ms);
 }
+
+// Trailing-edge debouncing: the returned trigger (re)starts a single shot
+// timer so that a burst of calls only runs `slot` once, `ms` after the last one
+template <class Slot>
+auto debounced(QObject *parent, int ms, Slot && slot) {
+    auto timer = new QTimer(parent);
+    QObject::connect(timer, &QTimer::timeout, std::forward<Slot>(slot));
+    timer->setSingleShot(true);
+    timer->setInterval(ms);
+
+    return [timer] { timer->start(); };
+}
@@ -2,6 +2,8 @@
 
 #include <QString>
 
+#include <QtPromise>
+
 namespace daemon_control {
     struct Status {
         bool running = false;
@@ -10,7 +12,16 @@ namespace daemon_control {
     };
 
     bool start();
-    bool stop();
+    QtPromise::QPromise<bool> stop();
+
+    // Never rejected: an unreachable daemon is reported as not running
+    QtPromise::QPromise<Status> status(int timeout_ms = 2000);
+    // Polls the daemon until it answers (with the given version, if any) or
+    // the timeout elapses, for right after it was started
+    QtPromise::QPromise<Status> wait_ready(const QString &version = { }, int timeout_ms = 5000);
 
-    Status status();
+    // Resolved once the daemon was probed, and started or upgraded if that
+    // was needed: playback waits for it
+    QtPromise::QPromise<void> ready();
+    void mark_ready();
 };
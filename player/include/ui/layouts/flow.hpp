@@ -13,6 +13,7 @@ public:
     ~FlowLayout();
 
     void addItem(QLayoutItem *) override;
+    void insertWidget(int, QWidget *);
     int horizontalSpacing() const;
     int verticalSpacing() const;
     Qt::Orientations expandingDirections() const override;
@@ -11,21 +11,21 @@
 
 #include "ui/layouts/splitter_grid.hpp"
 
+#include "libvlc/async_instance.hpp"
+
 namespace Ui {
 class MainWindow;
 }
 
-namespace libvlc {
-struct Instance;
-}
-
 class StreamPane;
 class ChatPane;
 class VLCLogViewer;
+class ApiDiagnostics;
 class QStackedWidget;
 class QShortcut;
 
 class TwitchPubSub;
+class StreamDirectory;
 
 using MPane = std::variant<
     StreamPane *,
@@ -34,7 +34,7 @@ using MPane = std::variant<
 
 class MainWindow : public QMainWindow {
 public:
-    MainWindow(libvlc::Instance &, TwitchPubSub &, QWidget * = nullptr);
+    MainWindow(libvlc::AsyncInstance, TwitchPubSub &, StreamDirectory &, QWidget * = nullptr);
     ~MainWindow();
 
     StreamPane *add_stream_pane(Position);
@@ -50,10 +50,12 @@ protected:
 private:
     std::unique_ptr<Ui::MainWindow> _ui;
 
-    libvlc::Instance &_video_context;
+    libvlc::AsyncInstance _video_context;
     TwitchPubSub &_pubsub;
+    StreamDirectory &_directory;
 
     std::unique_ptr<VLCLogViewer> _vlc_log_viewer;
+    std::unique_ptr<ApiDiagnostics> _api_diagnostics;
 
     std::vector<MPane> _panes;
     SplitterGrid *_grid;
@@ -29,6 +29,7 @@ public:
     void set_qualities(QString, QStringList);
 
     void set_delay(float);
+    void set_delay_summary(const QString &);
 
 protected:
     void mousePressEvent(QMouseEvent *) override;
@@ -2,6 +2,7 @@
 
 #include <QWidget>
 #include <QImage>
+#include <QElapsedTimer>
 
 #include <optional>
 
@@ -21,6 +22,8 @@ public:
     void show_stream_details();
 
     void set_channel(const QString &);
+    // Pushed viewer counts: REST polling pauses while they keep coming
+    void set_viewcount(int);
 
     void hide_stream_details();
 
@@ -45,13 +48,16 @@ private:
     QTimer *_stream_details_timer;
     bool _show_stream_details = false;
     bool _has_valid_stream_details = false;
-
-    QNetworkAccessManager *_http_client;
+    QDateTime _created_at;
+    QElapsedTimer _last_viewcount_push;
 
     void draw_state_text();
     void draw_spinner();
     void draw_stream_details();
 
+    void update_uptime();
+
+    void fill_stream_details(const StreamData &);
     void fetch_channel_details();
     void fetch_channel_logo(const QString &);
 
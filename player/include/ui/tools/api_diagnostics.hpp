@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QWidget>
+#include <QJsonObject>
+
+#include <functional>
+#include <memory>
+
+namespace Ui {
+    class ApiDiagnostics;
+}
+
+class ApiDiagnostics: public QWidget {
+public:
+    ApiDiagnostics(QWidget * = nullptr);
+    ~ApiDiagnostics();
+
+    // Everything the window shows, as a JSON document
+    static QJsonObject snapshot();
+
+protected:
+    void showEvent(QShowEvent *) override;
+
+private:
+    std::unique_ptr<Ui::ApiDiagnostics> _ui;
+
+    std::function<void ()> _schedule_refresh;
+
+    void refresh();
+    void refresh_endpoints();
+    void refresh_hosts();
+    void refresh_playback();
+    void save_snapshot();
+};
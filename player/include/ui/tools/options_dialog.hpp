@@ -2,6 +2,8 @@
 
 #include <QDialog>
 
+#include <QtPromise>
+
 #include <vector>
 #include <functional>
 #include <memory>
@@ -14,6 +16,10 @@ class QKeySequenceEdit;
 
 class TwitchPubSub;
 
+namespace daemon_control {
+    struct Status;
+}
+
 class OptionsDialog: public QDialog {
     Q_OBJECT
 
@@ -28,7 +34,8 @@ private:
     void load_settings();
     void save_settings();
 
-    void update_daemon(QString, std::function<void ()>);
+    void update_daemon(QString, std::function<QtPromise::QPromise<void> ()>);
+    void show_daemon_status(const daemon_control::Status &);
 
     TwitchPubSub &_pubsub;
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "api/twitchd.hpp"
+
+#include "prelude/histogram.hpp"
+
+#include <QObject>
+
+#include <optional>
+
+class MetadataStream;
+
+// Follows the end-to-end latency of a pane: segment metadata is pushed by
+// twitchd while the stream plays, and every playback time update yields
+// a latency sample that gets smoothed and recorded in a histogram
+class LatencyTracker: public QObject {
+    Q_OBJECT
+
+public:
+    LatencyTracker(QObject * = nullptr);
+
+    void track(QString, QString, QString);
+    void stop();
+
+    void sample(qint64 playback_time_ms);
+
+    // Smoothed latency, in milliseconds
+    std::optional<double> latency() const;
+    const Histogram & histogram() const;
+
+    QString summary() const;
+
+signals:
+    void latency_changed(double);
+
+private:
+    MetadataStream *_metadata_stream;
+
+    std::optional<SegmentMetadata> _metadata;
+    std::optional<double> _smoothed_ms;
+    Histogram _histogram;
+};
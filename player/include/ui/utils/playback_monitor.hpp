@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+
+#include <optional>
+
+namespace libvlc {
+    struct MediaPlayer;
+}
+
+class QTimer;
+
+// Watches a pane's output for stalls libvlc does not report: a picture
+// frozen on its last frame, or audio that stopped being played while the
+// video goes on.
+// Decoding statistics are sampled every second and, every few seconds, a
+// tiny snapshot of the current frame is hashed on a worker thread.
+// libvlc cannot tap the decoded audio without replacing the audio output,
+// so silence is detected as audio buffers no longer being played rather
+// than from their loudness
+class PlaybackMonitor: public QObject {
+    Q_OBJECT
+
+public:
+    PlaybackMonitor(libvlc::MediaPlayer &, QObject * = nullptr);
+    // Waits for a snapshot in progress, which uses the media player
+    ~PlaybackMonitor();
+
+    void start();
+    void stop();
+
+signals:
+    // Emitted once per start
+    void stalled(QString);
+
+private:
+    libvlc::MediaPlayer &_media_player;
+
+    QTimer *_sample_timer;
+    QFutureWatcher<std::optional<uint>> *_snapshot_watcher;
+    QString _snapshot_path;
+
+    int _ticks = 0;
+    std::optional<int> _displayed_pictures, _played_audio_buffers;
+    bool _audio_seen = false;
+    std::optional<uint> _frame_hash;
+
+    // In milliseconds, how long each symptom has lasted
+    int _pictures_stalled_for = 0;
+    int _audio_stalled_for = 0;
+    int _frame_identical_for = 0;
+
+    void sample();
+    void sample_frame();
+    void report(const QString &);
+};
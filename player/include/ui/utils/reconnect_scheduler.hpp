@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+
+#include <functional>
+
+class QTimer;
+
+// Process-wide pacing of the panes trying to play their stream again.
+// Every pane backs off exponentially (capped, with jitter) on its own, and
+// retries are admitted one at a time across every pane, so that a daemon
+// restart is not met with all of them at once.
+// A recovery (the daemon answering again, a channel going live) makes the
+// waiting retries due right away
+class ReconnectScheduler: public QObject {
+public:
+    static ReconnectScheduler &instance();
+
+    using Retry = std::function<void ()>;
+
+    // The client is forgotten when destroyed. The key identifies what it
+    // waits for (e.g. a channel) for targeted recoveries
+    void schedule(QObject *, const QString &, Retry);
+    // Keeps the backoff of the client, only drops its pending retry
+    void cancel(QObject *);
+    // The client is healthy: its next failure starts from the initial delay
+    void succeeded(QObject *);
+
+    // Every waiting client, or only those with that key
+    void recovered(const QString & = { });
+
+private:
+    ReconnectScheduler(QObject * = nullptr);
+
+    struct Client {
+        QString key;
+        Retry retry;
+        int failures = 0;
+        bool pending = false;
+        qint64 due_at_ms = 0;
+    };
+
+    QHash<QObject *, Client> _clients;
+
+    QTimer *_admission_timer;
+    QElapsedTimer _clock;
+    qint64 _last_admission_ms = -1;
+
+    int backoff_ms(int) const;
+    void admit_next();
+    void plan_admission();
+};
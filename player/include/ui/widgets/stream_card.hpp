@@ -4,6 +4,8 @@
 
 #include "api/twitch.hpp"
 
+#include "prelude/promise.hpp"
+
 namespace Ui {
     class StreamCard;
 }
@@ -18,8 +20,12 @@ public:
     StreamCard(StreamData, QWidget * = nullptr);
     ~StreamCard();
 
+    QString channel() const;
+    void set_viewcount(uint32_t);
+
 protected:
     void mousePressEvent(QMouseEvent *) override;
+    void paintEvent(QPaintEvent *) override;
 
 signals:
     void clicked(QString);
@@ -33,4 +39,9 @@ private:
     QLabel *_uptime_label;
 
     StreamData _data;
+
+    // Set once the preview download started
+    CancelToken _preview_fetch;
+
+    void fetch_preview();
 };
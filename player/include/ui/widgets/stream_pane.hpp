@@ -1,26 +1,27 @@
 #pragma once
 
+#include "libvlc/async_instance.hpp"
+
 #include <QWidget>
 
 #include <memory>
+#include <optional>
 
 class QHBoxLayout;
 class StreamPicker;
 class StreamWidget;
-
-namespace libvlc {
-    struct Instance;
-}
+class StreamDirectory;
 
 class StreamPane: public QWidget {
     Q_OBJECT
 
 public:
-    StreamPane(libvlc::Instance &, QWidget * = nullptr);
+    StreamPane(libvlc::AsyncInstance, StreamDirectory &, QWidget * = nullptr);
     ~StreamPane();
 
     void play(QString, QString = QString());
 
+    // Null until libvlc is ready
     StreamWidget *stream() const;
 
 protected:
@@ -34,12 +35,22 @@ signals:
     void fullscreen_requested(bool);
 
 private:
-    libvlc::Instance & _video_ctx;
+    libvlc::AsyncInstance _video_ctx;
+    std::shared_ptr<libvlc::Instance> _instance;
+    StreamDirectory & _directory;
 
     QHBoxLayout *_layout;
     std::unique_ptr<StreamPicker> _picker;
     std::unique_ptr<StreamWidget> _stream;
 
+    // Played once libvlc is ready
+    std::optional<std::pair<QString, QString>> _queued_play;
+
+    // Whose viewer count is pushed to the details overlay
+    QString _viewcount_channel;
+
     void setup_picker();
+    void create_stream();
     void setup_stream();
+    void watch_viewcount(const QString &);
 };
@@ -1,22 +1,26 @@
 #pragma once
 
 #include <QWidget>
+#include <QSet>
 
 #include <unordered_map>
 
 #include "api/twitch.hpp"
 
-#include "prelude/promise.hpp"
-
 namespace Ui {
     class StreamPicker;
 }
 
+class QScrollArea;
+class QStringListModel;
+class StreamCard;
+class StreamDirectory;
+
 class StreamPicker: public QWidget {
     Q_OBJECT
 
 public:
-    StreamPicker(QWidget * = nullptr);
+    StreamPicker(StreamDirectory &, QWidget * = nullptr);
     ~StreamPicker();
 
 protected:
@@ -31,11 +35,32 @@ private:
     QWidget *_channels_stream_presenter;
     QWidget *_followed_stream_presenter;
 
-    TwitchAPI _api;
-    std::unordered_map<QWidget *, CancelToken> current_queries;
+    StreamDirectory &_directory;
+    QStringListModel *_suggestions;
+
+    // Which directory listing a presenter shows, and how many of its pages
+    // have been laid out so far
+    struct Feed {
+        QString key;
+        int pages_presented = 0;
+        QSet<QString> channels_presented;
+    };
+
+    std::unordered_map<QWidget *, Feed> _feeds;
+
+    void watch_scrolling(QScrollArea *, QWidget *);
+
+    // Merging keeps what is already presented, for server results to join
+    // the local ones
+    void show_feed(QWidget *, QString, bool = false);
+    void reset_feed(QWidget *);
+    void load_next_page(QWidget *);
+
+    void present_local_matches(const QString &);
 
-    void fetch_streams(TwitchAPI::streams_response_t, QWidget *);
+    void clear_streams(QWidget *);
     void present_streams(QWidget *, QList<StreamData>);
+    StreamCard *make_card(const StreamData &, QWidget *);
 
     void channel_picked(QString);
 };
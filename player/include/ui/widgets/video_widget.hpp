@@ -10,6 +10,8 @@
 class VideoControls;
 class VideoDetails;
 class VLCEventWatcher;
+class LatencyTracker;
+class PlaybackMonitor;
 
 class VideoWidget: public QWidget {
 public:
@@ -31,6 +33,8 @@ public:
     libvlc::MediaPlayer & media_player();
 
     VideoControls & controls() const;
+    VideoDetails & details() const;
+    LatencyTracker & latency() const;
 
 protected:
     void wheelEvent(QWheelEvent *) override;
@@ -48,19 +52,24 @@ private:
     VideoControls *_controls;
 
     VLCEventWatcher *_event_watcher;
+    LatencyTracker *_latency;
+    PlaybackMonitor *_health;
 
     int _vol;
     bool _muted;
+    bool _waiting_for_daemon = false;
+    // So that only the panes that said it was unreachable say it is back
+    bool _daemon_unreachable_shown = false;
 
     QPoint _last_drag_position;
 
     TwitchdAPI _api;
 
-    QString _current_channel, _current_quality, _current_meta_key;
-    std::optional<SegmentMetadata> _current_metadata;
-
-    QTimer *_retry_timer;
+    QString _current_channel, _current_quality;
+    // Of the latest playback attempt
+    QString _meta_key;
 
     void update_overlay_position();
+    void schedule_retry();
 
 };
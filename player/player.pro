@@ -1,7 +1,7 @@
 TARGET          =   twitch-player
 TEMPLATE        =   app
 
-QT              +=  core gui widgets network websockets
+QT              +=  core gui widgets network websockets concurrent
 QTPLUGIN        +=  qsvg
 
 include(vendor/qtpromise-0.3.0/qtpromise.pri)
@@ -18,11 +18,21 @@ release:CONFIG  +=  static
 
 SOURCES         +=  src/main.cpp \
                     \
+                    src/api/channel_index.cpp \
+                    src/api/images.cpp \
+                    src/api/metrics.cpp \
+                    src/api/metadata_stream.cpp \
+                    src/api/network.cpp \
                     src/api/oauth.cpp \
                     src/api/pubsub.cpp \
+                    src/api/stream_directory.cpp \
+                    src/api/stream_prewarmer.cpp \
+                    src/api/thumbnail_store.cpp \
+                    src/api/token_manager.cpp \
                     src/api/twitch.cpp \
                     src/api/twitchd.cpp \
                     \
+                    src/libvlc/async_instance.cpp \
                     src/libvlc/bindings.cpp \
                     src/libvlc/event_watcher.cpp \
                     src/libvlc/logger.cpp \
@@ -40,11 +50,15 @@ SOURCES         +=  src/main.cpp \
                     src/ui/overlays/video_details.cpp \
                     \
                     src/ui/tools/about_dialog.cpp \
+                    src/ui/tools/api_diagnostics.cpp \
                     src/ui/tools/options_dialog.cpp \
                     src/ui/tools/video_filters.cpp \
                     src/ui/tools/vlc_log_viewer.cpp \
                     \
                     src/ui/utils/event_notifier.cpp \
+                    src/ui/utils/latency_tracker.cpp \
+                    src/ui/utils/playback_monitor.cpp \
+                    src/ui/utils/reconnect_scheduler.cpp \
                     \
                     src/ui/widgets/chat_pane.cpp \
                     src/ui/widgets/foreign_widget.cpp \
@@ -56,17 +70,28 @@ SOURCES         +=  src/main.cpp \
 
 HEADERS         +=  include/constants.hpp \
                     \
+                    include/api/channel_index.hpp \
+                    include/api/images.hpp \
+                    include/api/metrics.hpp \
+                    include/api/metadata_stream.hpp \
+                    include/api/network.hpp \
                     include/api/oauth.hpp \
                     include/api/pubsub.hpp \
+                    include/api/stream_directory.hpp \
+                    include/api/stream_prewarmer.hpp \
+                    include/api/thumbnail_store.hpp \
+                    include/api/token_manager.hpp \
                     include/api/twitch.hpp \
                     include/api/twitchd.hpp \
                     \
+                    include/libvlc/async_instance.hpp \
                     include/libvlc/bindings.hpp \
                     include/libvlc/event_watcher.hpp \
                     include/libvlc/logger.hpp \
                     include/libvlc/types.hpp \
                     \
                     include/prelude/c_wrapper.hpp \
+                    include/prelude/histogram.hpp \
                     include/prelude/http.hpp \
                     include/prelude/promise.hpp \
                     include/prelude/sync.hpp \
@@ -87,11 +112,15 @@ HEADERS         +=  include/constants.hpp \
                     include/ui/overlays/video_details.hpp \
                     \
                     include/ui/tools/about_dialog.hpp \
+                    include/ui/tools/api_diagnostics.hpp \
                     include/ui/tools/options_dialog.hpp \
                     include/ui/tools/video_filters.hpp \
                     include/ui/tools/vlc_log_viewer.hpp \
                     \
                     include/ui/utils/event_notifier.hpp \
+                    include/ui/utils/latency_tracker.hpp \
+                    include/ui/utils/playback_monitor.hpp \
+                    include/ui/utils/reconnect_scheduler.hpp \
                     \
                     include/ui/widgets/chat_pane.hpp \
                     include/ui/widgets/foreign_widget.hpp \
@@ -113,6 +142,7 @@ unix:!macx:HEADERS    +=  include/ui/native/x11.hpp
 FORMS           +=  forms/main_window.ui \
                     forms/stream_picker.ui \
                     forms/vlc_log_viewer.ui \
+                    forms/api_diagnostics.ui \
                     forms/about_dialog.ui \
                     forms/options_dialog.ui \
                     forms/stream_card.ui \
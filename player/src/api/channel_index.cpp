@@ -0,0 +1,207 @@
+#include "api/channel_index.hpp"
+#include "api/metrics.hpp"
+
+#include <QElapsedTimer>
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+
+// Live data older than that probably does not reflect the channel anymore
+constexpr auto LIVE_DATA_TTL_MS = 10 * 60 * 1000;
+
+static quint64 trigram_key(const QString &text, int index) {
+    return (static_cast<quint64>(text[index].unicode()) << 32)
+         | (static_cast<quint64>(text[index + 1].unicode()) << 16)
+         |  static_cast<quint64>(text[index + 2].unicode());
+}
+
+// Distinct, so that a repeated trigram does not count as several shared ones
+static QSet<quint64> trigrams(const QString &text) {
+    QSet<quint64> keys;
+
+    for (int i = 0; i + 3 <= text.size(); ++i)
+        keys.insert(trigram_key(text, i));
+
+    return keys;
+}
+
+// Both the name and the display name are indexed
+static QSet<quint64> trigrams(const QString &key, const QString &display_key) {
+    return trigrams(key).unite(trigrams(display_key));
+}
+
+// The display name is only known from stream data, an entry keeps the one
+// it had
+void ChannelIndex::insert(const QString &name, Source source) {
+    if (!name.isEmpty())
+        upsert(name, { }, source);
+}
+
+void ChannelIndex::insert(const StreamData &stream, Source source) {
+    auto & channel = stream.channel;
+
+    if (channel.name.isEmpty())
+        return;
+
+    auto & entry = _entries[upsert(channel.name, channel.display_name, source)];
+    entry.stream = stream;
+    entry.seen_live.start();
+}
+
+int ChannelIndex::upsert(const QString &name, const QString &display_name, Source source) {
+    auto key = name.toLower();
+    auto source_rank = static_cast<int>(source);
+
+    if (auto id_it = _ids.find(key); id_it != _ids.end()) {
+        auto & entry = _entries[*id_it];
+        entry.source_rank = std::min(entry.source_rank, source_rank);
+
+        auto display_key = display_name.toLower();
+        if (!display_key.isEmpty() && display_key != entry.display_key) {
+            auto previous = trigrams(entry.key, entry.display_key);
+            auto current = trigrams(entry.key, display_key);
+
+            entry.display_key = display_key;
+            unindex_trigrams(*id_it, QSet<quint64>(previous).subtract(current));
+            index_trigrams(*id_it, current.subtract(previous));
+        }
+
+        return *id_it;
+    }
+
+    auto id = static_cast<int>(_entries.size());
+
+    Entry entry;
+    entry.name = name;
+    entry.key = key;
+    entry.display_key = display_name.isEmpty() ? key : display_name.toLower();
+    entry.source_rank = source_rank;
+
+    _entries.push_back(entry);
+    _ids.insert(key, id);
+    _sorted_dirty = true;
+
+    index_trigrams(id, trigrams(key, entry.display_key));
+
+    return id;
+}
+
+void ChannelIndex::index_trigrams(int id, const QSet<quint64> &keys) {
+    for (auto trigram: keys)
+        _trigrams[trigram].push_back(id);
+}
+
+void ChannelIndex::unindex_trigrams(int id, const QSet<quint64> &keys) {
+    for (auto trigram: keys) {
+        auto ids_it = _trigrams.find(trigram);
+        if (ids_it == _trigrams.end())
+            continue;
+
+        auto & ids = *ids_it;
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+        if (ids.empty())
+            _trigrams.erase(ids_it);
+    }
+}
+
+void ChannelIndex::ensure_sorted() const {
+    if (!_sorted_dirty)
+        return;
+
+    _sorted_ids.resize(_entries.size());
+    for (size_t i = 0; i < _entries.size(); ++i)
+        _sorted_ids[i] = static_cast<int>(i);
+
+    std::sort(_sorted_ids.begin(), _sorted_ids.end(), [this](int lhs, int rhs) {
+        return _entries[lhs].key < _entries[rhs].key;
+    });
+
+    _sorted_dirty = false;
+}
+
+QList<ChannelIndex::Match> ChannelIndex::search(const QString &query, int limit) const {
+    auto needle = query.trimmed().toLower();
+
+    if (needle.isEmpty())
+        return { };
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QHash<int, int> candidates; // id -> shared trigrams
+
+    // Every name starting with the query
+    ensure_sorted();
+    auto prefix_begin = std::lower_bound(
+        _sorted_ids.begin(), _sorted_ids.end(), needle,
+        [this](int id, const QString &needle) { return _entries[id].key < needle; }
+    );
+    for (auto it = prefix_begin; it != _sorted_ids.end() && _entries[*it].key.startsWith(needle); ++it)
+        candidates.insert(*it, 0);
+
+    // Names sharing enough trigrams with the query, which tolerates typos
+    // and matches in the middle of names
+    auto needle_trigrams = trigrams(needle);
+    for (auto trigram: needle_trigrams) {
+        auto ids_it = _trigrams.find(trigram);
+        if (ids_it == _trigrams.end())
+            continue;
+
+        for (auto id: *ids_it)
+            candidates[id] += 1;
+    }
+
+    auto min_shared = std::max(1, needle_trigrams.size() / 2);
+
+    QList<Match> matches;
+    for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+        auto & entry = _entries[it.key()];
+        auto is_prefix = entry.key.startsWith(needle) || entry.display_key.startsWith(needle);
+
+        if (!is_prefix && it.value() < min_shared)
+            continue;
+
+        auto live = entry.stream && entry.seen_live.isValid()
+                 && !entry.seen_live.hasExpired(LIVE_DATA_TTL_MS);
+
+        matches << Match {
+            entry.name,
+            score(entry, needle, it.value()),
+            live ? entry.stream : std::nullopt
+        };
+    }
+
+    std::sort(matches.begin(), matches.end(), [](auto & lhs, auto & rhs) {
+        return lhs.score > rhs.score;
+    });
+
+    ApiMetrics::instance().record_channel_search(timer.nsecsElapsed() / 1000);
+
+    return matches.mid(0, limit);
+}
+
+double ChannelIndex::score(const Entry &entry, const QString &needle, int shared_trigrams) const {
+    double score;
+
+    if (entry.key == needle || entry.display_key == needle)
+        score = 100;
+    else if (entry.key.startsWith(needle) || entry.display_key.startsWith(needle))
+        // Shorter completions first
+        score = 80 - std::min(20, entry.key.size() - needle.size());
+    else if (entry.key.contains(needle) || entry.display_key.contains(needle))
+        score = 50;
+    else {
+        // Dice coefficient over trigrams
+        auto total = std::max(1, (needle.size() - 2) + (entry.key.size() - 2));
+        score = 40. * 2 * shared_trigrams / total;
+    }
+
+    // Channels the user cares about come first
+    score += 15 - 5 * entry.source_rank;
+
+    if (entry.stream && entry.seen_live.isValid() && !entry.seen_live.hasExpired(LIVE_DATA_TTL_MS))
+        score += 5 + std::log10(1. + entry.stream->viewcount);
+
+    return score;
+}
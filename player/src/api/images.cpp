@@ -0,0 +1,166 @@
+#include "api/images.hpp"
+#include "api/network.hpp"
+#include "api/thumbnail_store.hpp"
+
+#include <QCoreApplication>
+#include <QImageReader>
+#include <QBuffer>
+
+#include <QtConcurrent>
+
+#include <algorithm>
+
+constexpr auto PIXMAP_CACHE_SIZE_KB = 64 * 1024;
+constexpr auto MAX_DECODE_THREADS = 2;
+// Twitch regenerates previews every few minutes
+constexpr auto PIXMAP_MAX_AGE_MS = 5 * 60 * 1000;
+constexpr auto STORE_SIZE_BYTES = 32 * 1024 * 1024;
+constexpr auto MAX_STORE_SLOTS = 512;
+
+static QString size_key(QSize size) {
+    return QString("%1x%2").arg(size.width()).arg(size.height());
+}
+
+static QString cache_key(const QString &url, QSize size) {
+    return QString("%1@%2").arg(url).arg(size_key(size));
+}
+
+// Runs on the decode pool: only touches QImage, which is safe off the GUI
+// thread. Scaling happens inside the decoder (JPEG can decode at a fraction
+// of its size) and the result is already in the format the raster engine
+// paints from, so the GUI thread only has to upload it
+static QImage decode_scaled(QByteArray data, QSize size) {
+    QBuffer buffer { &data };
+    QImageReader reader { &buffer };
+
+    auto original_size = reader.size();
+    if (original_size.isValid() &&
+        (original_size.width() > size.width() || original_size.height() > size.height()))
+    {
+        reader.setScaledSize(original_size.scaled(size, Qt::KeepAspectRatio));
+    }
+
+    return reader.read().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+ImageService &ImageService::instance() {
+    static auto service = new ImageService(qApp);
+    return *service;
+}
+
+ImageService::ImageService(QObject *parent):
+    QObject(parent),
+    _pixmaps(PIXMAP_CACHE_SIZE_KB)
+{
+    _decode_pool.setMaxThreadCount(MAX_DECODE_THREADS);
+}
+
+ImageService::image_response_t ImageService::fetch(const QString &url, QSize size,
+                                                   CancelToken token)
+{
+    using QtPromise::QPromise;
+
+    auto key = cache_key(url, size);
+
+    if (auto cached = _pixmaps.object(key); cached && !cached->age.hasExpired(PIXMAP_MAX_AGE_MS))
+        return QPromise<QPixmap>::resolve(cached->pixmap);
+
+    // Several cards (possibly in several pickers) usually ask for the same
+    // preview at the same time: share a single download and decode
+    if (auto in_flight_it = _in_flight.find(key); in_flight_it != _in_flight.end()) {
+        add_waiter(key, token);
+        return in_flight_it->response;
+    }
+
+    QNetworkRequest request { QUrl { url } };
+    request.setAttribute(ENDPOINT_ATTRIBUTE, "image");
+    request.setAttribute(PRIORITY_ATTRIBUTE, static_cast<int>(Priority::Background));
+
+    auto download_token = std::make_shared<Cancellable>();
+    auto download = NetworkService::instance().fetch(request, "GET", { }, download_token);
+
+    auto decode = [=](const QByteArray &data) {
+        return QtConcurrent::run(&_decode_pool, decode_scaled, data, size);
+    };
+
+    auto upload = [=](const QImage &image) {
+        auto pixmap = QPixmap::fromImage(image);
+
+        if (!pixmap.isNull()) {
+            auto cost_kb = std::max(1, static_cast<int>(image.sizeInBytes() / 1024));
+            auto cached = new CachedPixmap { pixmap, { } };
+            cached->age.start();
+            _pixmaps.insert(key, cached, cost_kb);
+
+            if (auto store = store_for(size))
+                store->store(url, image);
+        }
+
+        return pixmap;
+    };
+
+    auto response = download
+        .then(decode)
+        .then(upload)
+        .finally([=] { _in_flight.remove(key); });
+
+    _in_flight.insert(key, InFlight { response, download_token, 0 });
+    add_waiter(key, token);
+
+    return response;
+}
+
+// Callers without a token wait until the end
+void ImageService::add_waiter(const QString &key, CancelToken token) {
+    auto in_flight_it = _in_flight.find(key);
+    if (in_flight_it == _in_flight.end())
+        return;
+
+    in_flight_it->waiters += 1;
+
+    if (!token)
+        return;
+
+    token->on_cancel([=, download_token = in_flight_it->download_token] {
+        auto in_flight_it = _in_flight.find(key);
+        if (in_flight_it == _in_flight.end() || in_flight_it->download_token != download_token)
+            return;
+
+        if (--in_flight_it->waiters == 0)
+            download_token->cancel();
+    });
+}
+
+std::optional<QPixmap> ImageService::cached(const QString &url, QSize size) {
+    if (auto cached = _pixmaps.object(cache_key(url, size)))
+        return cached->pixmap;
+
+    if (auto store = store_for(size)) {
+        if (auto image = store->lookup(url))
+            return QPixmap::fromImage(*image);
+    }
+
+    return std::nullopt;
+}
+
+// One atlas per display size, so that every slot fits its thumbnails exactly
+ThumbnailStore *ImageService::store_for(QSize size) {
+    if (size.isEmpty())
+        return nullptr;
+
+    auto key = size_key(size);
+
+    if (auto store_it = _stores.find(key); store_it != _stores.end())
+        return *store_it;
+
+    auto slot_bytes = static_cast<qint64>(size.width()) * size.height() * 4;
+    auto capacity = static_cast<int>(std::min<qint64>(MAX_STORE_SLOTS, STORE_SIZE_BYTES / slot_bytes));
+
+    ThumbnailStore *store = nullptr;
+    if (capacity > 0)
+        store = new ThumbnailStore("thumbnails-" + key, size, capacity, this);
+
+    _stores.insert(key, store);
+
+    return store;
+}
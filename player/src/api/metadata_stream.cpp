@@ -0,0 +1,96 @@
+#include "api/metadata_stream.hpp"
+#include "api/network.hpp"
+
+#include <QTimer>
+
+constexpr auto INITIAL_RECONNECT_DELAY_MS = 500;
+constexpr auto MAX_RECONNECT_DELAY_MS = 8'000;
+
+MetadataStream::MetadataStream(QObject *parent):
+    QObject(parent),
+    _reconnect_timer(new QTimer(this))
+{
+    _reconnect_timer->setSingleShot(true);
+    _reconnect_timer->setInterval(INITIAL_RECONNECT_DELAY_MS);
+    QObject::connect(_reconnect_timer, &QTimer::timeout, [=] {
+        connect_stream();
+        auto next_delay = std::min(_reconnect_timer->interval() * 2, MAX_RECONNECT_DELAY_MS);
+        _reconnect_timer->setInterval(next_delay);
+    });
+}
+
+MetadataStream::~MetadataStream() {
+    close();
+}
+
+void MetadataStream::open(QString channel, QString quality, QString meta_key) {
+    close();
+
+    _url = TwitchdAPI::metadata_stream_url(channel, quality, meta_key);
+    _reconnect_timer->setInterval(INITIAL_RECONNECT_DELAY_MS);
+
+    connect_stream();
+}
+
+void MetadataStream::close() {
+    _url.clear();
+    _reconnect_timer->stop();
+    _buffer.clear();
+
+    if (_reply) {
+        // Detach first: aborting emits finished, which would reconnect
+        _reply->disconnect(this);
+        _reply->abort();
+        _reply->deleteLater();
+    }
+}
+
+void MetadataStream::connect_stream() {
+    if (_url.isEmpty())
+        return;
+
+    _buffer.clear();
+
+    auto reply = NetworkService::instance().open_stream(QNetworkRequest { _url });
+    _reply = reply;
+
+    QObject::connect(reply, &QNetworkReply::readyRead, this, [=] {
+        _buffer.append(reply->readAll());
+        consume_events();
+    });
+
+    QObject::connect(reply, &QNetworkReply::finished, this, [=] {
+        reply->deleteLater();
+
+        if (!_url.isEmpty())
+            _reconnect_timer->start();
+    });
+}
+
+// Events are separated by a blank line, only their `data` fields matter to us
+void MetadataStream::consume_events() {
+    int event_end;
+
+    while ((event_end = _buffer.indexOf("\n\n")) != -1) {
+        auto event = _buffer.left(event_end);
+        _buffer.remove(0, event_end + 2);
+
+        QByteArray data;
+        for (auto line: event.split('\n')) {
+            if (!line.startsWith("data:"))
+                continue;
+
+            if (!data.isEmpty())
+                data.append('\n');
+            data.append(line.mid(5).trimmed());
+        }
+
+        if (data.isEmpty())
+            continue;
+
+        // The stream is healthy again
+        _reconnect_timer->setInterval(INITIAL_RECONNECT_DELAY_MS);
+
+        emit metadata_received(TwitchdAPI::parse_metadata(data));
+    }
+}
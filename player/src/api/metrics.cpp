@@ -0,0 +1,172 @@
+#include "api/metrics.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <memory>
+
+constexpr auto MAX_PLAYBACK_EVENTS = 200;
+constexpr auto GUI_LAG_SAMPLE_INTERVAL_MS = 100;
+
+static QJsonObject histogram_json(const Histogram &histogram) {
+    return QJsonObject {
+        { "count", static_cast<qint64>(histogram.count()) },
+        { "mean",  histogram.mean() },
+        { "p50",   histogram.percentile(50) },
+        { "p90",   histogram.percentile(90) },
+        { "p95",   histogram.percentile(95) },
+        { "p99",   histogram.percentile(99) },
+        { "max",   histogram.max() },
+    };
+}
+
+ApiMetrics &ApiMetrics::instance() {
+    static auto metrics = new ApiMetrics(qApp);
+    return *metrics;
+}
+
+ApiMetrics::ApiMetrics(QObject *parent):
+    QObject(parent)
+{
+    // Not worth a redraw of the diagnostics on its own: no `updated` signal
+    auto sampler = new QTimer(this);
+    auto since_tick = std::make_shared<QElapsedTimer>();
+
+    sampler->setTimerType(Qt::PreciseTimer);
+    QObject::connect(sampler, &QTimer::timeout, [=] {
+        _gui_loop.lag.record(since_tick->restart() - GUI_LAG_SAMPLE_INTERVAL_MS);
+    });
+
+    since_tick->start();
+    sampler->start(GUI_LAG_SAMPLE_INTERVAL_MS);
+}
+
+void ApiMetrics::record_exchange(const QString &endpoint, const Exchange &exchange) {
+    auto & metrics = _endpoints[endpoint];
+
+    if (exchange.completed) {
+        metrics.queue.record(exchange.queue_ms);
+        if (exchange.connect_ms >= 0)
+            metrics.connect.record(exchange.connect_ms);
+        if (exchange.ttfb_ms >= 0)
+            metrics.ttfb.record(exchange.ttfb_ms);
+        metrics.total.record(exchange.total_ms);
+    }
+    metrics.bytes += static_cast<quint64>(exchange.bytes);
+    metrics.outcomes[exchange.outcome] += 1;
+
+    emit updated();
+}
+
+void ApiMetrics::record_parse(const QString &endpoint, qint64 parse_us) {
+    auto & metrics = _endpoints[endpoint];
+
+    metrics.parse.record(parse_us);
+
+    emit updated();
+}
+
+void ApiMetrics::record_hedge_sent(const QString &endpoint) {
+    _endpoints[endpoint].hedges_sent += 1;
+
+    emit updated();
+}
+
+void ApiMetrics::record_hedge_won(const QString &endpoint) {
+    _endpoints[endpoint].hedges_won += 1;
+
+    emit updated();
+}
+
+void ApiMetrics::record_startup(qint64 time_to_first_picker_ms, bool warmed_up) {
+    _startup.time_to_first_picker_ms = time_to_first_picker_ms;
+    _startup.warmed_up = warmed_up;
+
+    emit updated();
+}
+
+void ApiMetrics::record_daemon_ready(qint64 time_to_daemon_ready_ms) {
+    _startup.time_to_daemon_ready_ms = time_to_daemon_ready_ms;
+
+    emit updated();
+}
+
+void ApiMetrics::record_vlc_ready(qint64 time_to_vlc_ready_ms) {
+    _startup.time_to_vlc_ready_ms = time_to_vlc_ready_ms;
+
+    emit updated();
+}
+
+void ApiMetrics::record_pubsub_reconnect(bool pong_timeout) {
+    _pubsub.reconnects += 1;
+    if (pong_timeout)
+        _pubsub.pong_timeouts += 1;
+
+    emit updated();
+}
+
+void ApiMetrics::record_pubsub_resubscribe(qint64 ms) {
+    _pubsub.resubscribe.record(ms);
+
+    emit updated();
+}
+
+void ApiMetrics::record_playback_event(const QString &channel, const QString &reason) {
+    _playback_events << PlaybackEvent { QDateTime::currentDateTime(), channel, reason };
+
+    while (_playback_events.size() > MAX_PLAYBACK_EVENTS)
+        _playback_events.removeFirst();
+
+    emit updated();
+}
+
+void ApiMetrics::record_channel_search(qint64 us) {
+    _gui_loop.channel_search.record(us);
+
+    emit updated();
+}
+
+const QList<ApiMetrics::PlaybackEvent> & ApiMetrics::playback_events() const {
+    return _playback_events;
+}
+
+const QMap<QString, ApiMetrics::EndpointMetrics> & ApiMetrics::endpoints() const {
+    return _endpoints;
+}
+
+const ApiMetrics::Startup & ApiMetrics::startup() const {
+    return _startup;
+}
+
+const ApiMetrics::PubSub & ApiMetrics::pubsub() const {
+    return _pubsub;
+}
+
+const ApiMetrics::GuiLoop & ApiMetrics::gui_loop() const {
+    return _gui_loop;
+}
+
+QJsonObject ApiMetrics::to_json() const {
+    QJsonObject json;
+
+    for (auto it = _endpoints.begin(); it != _endpoints.end(); ++it) {
+        QJsonObject outcomes;
+        for (auto outcome_it = it->outcomes.begin(); outcome_it != it->outcomes.end(); ++outcome_it)
+            outcomes.insert(outcome_it.key(), static_cast<qint64>(outcome_it.value()));
+
+        json.insert(it.key(), QJsonObject {
+            { "queue_ms",   histogram_json(it->queue) },
+            { "connect_ms", histogram_json(it->connect) },
+            { "ttfb_ms",    histogram_json(it->ttfb) },
+            { "total_ms",   histogram_json(it->total) },
+            { "parse_us",   histogram_json(it->parse) },
+            { "bytes",      static_cast<qint64>(it->bytes) },
+            { "hedges_sent", static_cast<qint64>(it->hedges_sent) },
+            { "hedges_won",  static_cast<qint64>(it->hedges_won) },
+            { "outcomes",   outcomes },
+        });
+    }
+
+    return json;
+}
@@ -0,0 +1,454 @@
+#include "api/network.hpp"
+#include "api/metrics.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMetaEnum>
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QSslConfiguration>
+#include <QTimer>
+
+// Matches the connection pool Qt keeps per host for HTTP/1.1, so that
+// queued requests never wait on a connection of their own
+constexpr auto MAX_IN_FLIGHT_PER_HOST = 6;
+// Hosts seen speaking HTTP/2 multiplex every request on a single connection,
+// up to the number of concurrent streams Qt allows by default
+constexpr auto MAX_IN_FLIGHT_PER_HTTP2_HOST = 100;
+// Per priority class, across every host (0 for no limit)
+constexpr std::array<int, PRIORITY_COUNT> MAX_IN_FLIGHT_PER_CLASS = { 0, 0, 4 };
+
+// Per priority class, counted from the moment the request is sent
+constexpr std::array<int, PRIORITY_COUNT> DEADLINES_MS = { 5'000, 15'000, 30'000 };
+
+// Hedging waits for the p95 of the endpoint, once it is known well enough
+constexpr auto MIN_HEDGE_SAMPLES = 20;
+constexpr auto DEFAULT_HEDGE_DELAY_MS = 1'000;
+constexpr auto MIN_HEDGE_DELAY_MS = 50;
+
+// Consecutive failures of a host before its breaker opens, and how long it
+// stays open: doubled (with jitter) every time the probe fails
+constexpr auto BREAKER_FAILURE_THRESHOLD = 5;
+constexpr auto BREAKER_INITIAL_BACKOFF_MS = 1'000;
+constexpr auto BREAKER_MAX_BACKOFF_MS = 60'000;
+constexpr auto BREAKER_JITTER = 0.2;
+
+// Whether the host itself is failing, as opposed to that one request (not
+// found, unauthorized, ...)
+static bool is_host_failure(QNetworkReply::NetworkError error, bool timed_out) {
+    if (timed_out)
+        return true;
+
+    auto connection_error = error > QNetworkReply::NoError
+                         && error < QNetworkReply::ProxyConnectionRefusedError
+                         && error != QNetworkReply::OperationCanceledError;
+    auto server_error = error >= QNetworkReply::InternalServerError
+                     && error <= QNetworkReply::UnknownServerError;
+
+    return connection_error || server_error;
+}
+
+static int hedge_delay_ms(const QString &endpoint) {
+    auto & endpoints = ApiMetrics::instance().endpoints();
+
+    auto metrics_it = endpoints.find(endpoint);
+    if (metrics_it == endpoints.end() || metrics_it->total.count() < MIN_HEDGE_SAMPLES)
+        return DEFAULT_HEDGE_DELAY_MS;
+
+    return std::max(MIN_HEDGE_DELAY_MS, static_cast<int>(metrics_it->total.percentile(95)));
+}
+
+static int priority_of(const QNetworkRequest &request) {
+    auto priority = request
+        .attribute(PRIORITY_ATTRIBUTE, static_cast<int>(Priority::Default))
+        .toInt();
+
+    return qBound(0, priority, PRIORITY_COUNT - 1);
+}
+
+static QString outcome_name(QNetworkReply::NetworkError error) {
+    if (error == QNetworkReply::NoError)
+        return "ok";
+
+    auto key = QMetaEnum::fromType<QNetworkReply::NetworkError>().valueToKey(error);
+    return key ? QString(key) : QString::number(error);
+}
+
+NetworkService &NetworkService::instance() {
+    static auto service = new NetworkService(qApp);
+    return *service;
+}
+
+NetworkService::NetworkService(QObject *parent):
+    QObject(parent),
+    _http_client(new QNetworkAccessManager(this)),
+    _stream_client(new QNetworkAccessManager(this))
+{
+    _http_client->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
+
+    // Emitted once per new encrypted connection, never for reused ones
+    QObject::connect(_http_client, &QNetworkAccessManager::encrypted, [=](auto reply) {
+        _hosts[reply->url().host()].stats.connections_opened += 1;
+    });
+}
+
+NetworkService::response_t NetworkService::fetch(QNetworkRequest request,
+                                                 const QByteArray &verb,
+                                                 const QByteArray &body,
+                                                 CancelToken token)
+{
+    using QtPromise::QPromise;
+
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    return QPromise<QByteArray>([=](auto& resolve, auto& reject) {
+        if (token && token->cancelled()) {
+            reject(CancelError { });
+            return;
+        }
+
+        auto host = request.url().host();
+        auto endpoint = request.attribute(ENDPOINT_ATTRIBUTE, host).toString();
+        auto priority = priority_of(request);
+        auto bypass_breaker = request.attribute(BYPASS_BREAKER_ATTRIBUTE, false).toBool();
+
+        if (request.url().scheme() == "https")
+            _hosts[host].stats.encrypted = true;
+
+        // Whether this fetch is the one deciding if a half-open breaker
+        // closes. Cleared once it did (or could not), so that its hedge
+        // does not decide a second time
+        auto probe = std::make_shared<bool>(false);
+
+        if (!bypass_breaker && !admit(host, *probe)) {
+            ApiMetrics::Exchange exchange;
+            exchange.outcome = "breaker_open";
+            ApiMetrics::instance().record_exchange(endpoint, exchange);
+
+            reject(QNetworkReply::TemporaryNetworkFailureError);
+            return;
+        }
+
+        // Shared by the first attempt and its hedge: whichever finishes
+        // first settles the fetch and aborts the other one
+        auto settled = std::make_shared<bool>(false);
+        auto running = std::make_shared<int>(0);
+        auto replies = std::make_shared<QList<QPointer<QNetworkReply>>>();
+
+        // Settles right away, even if the request is still queued
+        if (token)
+            token->on_cancel([=] { reject(CancelError { }); });
+
+        auto attempt = [=](bool hedge) -> Dispatch {
+            auto queued = std::make_shared<QElapsedTimer>();
+            queued->start();
+
+            return [=] {
+                if (*settled || (token && token->cancelled())) {
+                    // No verdict on the host, a probe has to be sent again
+                    if (*probe) {
+                        *probe = false;
+                        _hosts[host].probing = false;
+                    }
+                    return false;
+                }
+
+                auto reply = _http_client->sendCustomRequest(request, verb, body);
+                replies->append(reply);
+                *running += 1;
+
+                auto exchange = std::make_shared<ApiMetrics::Exchange>();
+                exchange->queue_ms = queued->elapsed();
+
+                auto timer = std::make_shared<QElapsedTimer>();
+                timer->start();
+
+                // A hung exchange must not leave its caller waiting forever
+                auto timed_out = std::make_shared<bool>(false);
+                QTimer::singleShot(DEADLINES_MS[priority], reply, [=] {
+                    *timed_out = true;
+                    reply->abort();
+                });
+
+                // DNS resolution is not exposed by Qt, it ends up in the connect
+                // time (or the time to first byte for plain connections)
+                QObject::connect(reply, &QNetworkReply::encrypted, [=] {
+                    exchange->connect_ms = timer->elapsed();
+                });
+                QObject::connect(reply, &QNetworkReply::metaDataChanged, [=] {
+                    if (exchange->ttfb_ms < 0)
+                        exchange->ttfb_ms = timer->elapsed();
+                });
+
+                if (token) {
+                    token->on_cancel([reply = QPointer<QNetworkReply>(reply)] {
+                        if (reply)
+                            reply->abort();
+                    });
+                }
+
+                QObject::connect(reply, &QNetworkReply::finished, [=] {
+                    *running -= 1;
+
+                    auto error = reply->error();
+
+                    if (reply->attribute(QNetworkRequest::HTTP2WasUsedAttribute).toBool()) {
+                        _hosts[host].stats.http2_requests += 1;
+                        _hosts[host].http2 = true;
+                    }
+
+                    auto cancelled = token && token->cancelled();
+                    auto superseded = *settled;
+                    auto data = reply->readAll();
+
+                    exchange->total_ms = timer->elapsed();
+                    exchange->bytes = data.size();
+                    exchange->outcome = cancelled  ? "cancelled"
+                                      : superseded ? "superseded"
+                                      : *timed_out ? "timeout"
+                                      : outcome_name(error);
+                    exchange->completed = !cancelled && !superseded && !*timed_out
+                        && reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid();
+                    ApiMetrics::instance().record_exchange(endpoint, *exchange);
+
+                    if (bypass_breaker) {
+                        // Not accounted, see BYPASS_BREAKER_ATTRIBUTE
+                    }
+                    else if (!cancelled && !superseded) {
+                        report(host, !is_host_failure(error, *timed_out), *probe);
+                        *probe = false;
+                    }
+                    else if (*probe) {
+                        *probe = false;
+                        _hosts[host].probing = false;
+                    }
+
+                    // A failed attempt leaves the decision to the other one
+                    // if it is still running
+                    auto failed = !cancelled && error != QNetworkReply::NoError;
+                    auto settles = !superseded && !(failed && *running > 0);
+
+                    if (settles) {
+                        *settled = true;
+
+                        for (auto & other_reply: *replies) {
+                            if (other_reply && other_reply != reply)
+                                other_reply->abort();
+                        }
+
+                        // A cancelled reply never reaches the parsing continuations
+                        if (cancelled)
+                            reject(CancelError { });
+                        else if (*timed_out)
+                            reject(QNetworkReply::TimeoutError);
+                        else if (error == QNetworkReply::NoError) {
+                            if (hedge)
+                                ApiMetrics::instance().record_hedge_won(endpoint);
+                            resolve(data);
+                        }
+                        else
+                            reject(error);
+                    }
+
+                    reply->deleteLater();
+                    release(host, priority);
+                });
+
+                return true;
+            };
+        };
+
+        enqueue(host, priority, attempt(false));
+
+        // Only once the first attempt has actually been sent: hedging a
+        // request still waiting in the queue would only make the queue longer
+        auto hedgeable = verb == "GET" && request.attribute(HEDGE_ATTRIBUTE, false).toBool();
+        if (hedgeable) {
+            QTimer::singleShot(hedge_delay_ms(endpoint), this, [=] {
+                if (*settled || *running == 0 || (token && token->cancelled()))
+                    return;
+                if (_hosts[host].stats.breaker != BreakerState::Closed)
+                    return;
+
+                ApiMetrics::instance().record_hedge_sent(endpoint);
+                enqueue(host, priority, attempt(true));
+            });
+        }
+    });
+}
+
+QNetworkReply *NetworkService::open_stream(QNetworkRequest request) {
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    request.setRawHeader("Accept", "text/event-stream");
+
+    _hosts[request.url().host()].stats.requests += 1;
+
+    return _stream_client->get(request);
+}
+
+void NetworkService::warm_up(const QList<QUrl> &urls) {
+    // Offers h2 like the requests that allow HTTP/2 do, otherwise the
+    // warmed up connection ends up in the HTTP/1.1 pool and the first
+    // request opens a new one anyway
+    auto ssl_config = QSslConfiguration::defaultConfiguration();
+    ssl_config.setAllowedNextProtocols({
+        QSslConfiguration::ALPNProtocolHTTP2,
+        QSslConfiguration::NextProtocolHttp1_1,
+    });
+
+    for (auto & url: urls) {
+        if (url.scheme() == "https")
+            _http_client->connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(443)), ssl_config);
+        else
+            _http_client->connectToHost(url.host(), static_cast<quint16>(url.port(80)));
+
+        _hosts[url.host()].stats.warmed_up = true;
+    }
+}
+
+QHash<QString, NetworkService::HostStats> NetworkService::stats() const {
+    QHash<QString, HostStats> stats;
+
+    for (auto it = _hosts.begin(); it != _hosts.end(); ++it) {
+        auto host_stats = it->stats;
+        host_stats.queued = 0;
+        for (auto & queue: it->queues)
+            host_stats.queued += queue.size();
+        stats.insert(it.key(), host_stats);
+    }
+
+    return stats;
+}
+
+qint64 NetworkService::retry_in_ms(const QString &host) const {
+    auto pool_it = _hosts.find(host);
+    if (pool_it == _hosts.end() || pool_it->stats.breaker != BreakerState::Open)
+        return 0;
+
+    return std::max<qint64>(0, pool_it->backoff_ms - pool_it->breaker_opened.elapsed());
+}
+
+// Past the backoff, the first request to come through is the probe and the
+// others keep failing fast until it has answered
+bool NetworkService::admit(const QString &host, bool &probe) {
+    auto & pool = _hosts[host];
+    probe = false;
+
+    switch (pool.stats.breaker) {
+        case BreakerState::Closed:
+            return true;
+
+        case BreakerState::Open:
+            if (!pool.breaker_opened.hasExpired(pool.backoff_ms))
+                return false;
+
+            set_breaker(host, BreakerState::HalfOpen);
+            pool.probing = true;
+            probe = true;
+            return true;
+
+        case BreakerState::HalfOpen:
+            if (pool.probing)
+                return false;
+
+            pool.probing = true;
+            probe = true;
+            return true;
+    }
+
+    return true;
+}
+
+void NetworkService::report(const QString &host, bool success, bool probe) {
+    auto & pool = _hosts[host];
+
+    // Requests admitted before the breaker opened can still complete while
+    // it is half-open: only the probe gets to decide
+    if (probe)
+        pool.probing = false;
+    else if (pool.stats.breaker == BreakerState::HalfOpen)
+        return;
+
+    if (success) {
+        pool.stats.consecutive_failures = 0;
+        pool.backoff_ms = 0;
+        set_breaker(host, BreakerState::Closed);
+        return;
+    }
+
+    pool.stats.consecutive_failures += 1;
+
+    auto trips = pool.stats.breaker == BreakerState::HalfOpen
+              || pool.stats.consecutive_failures >= BREAKER_FAILURE_THRESHOLD;
+    if (!trips || pool.stats.breaker == BreakerState::Open)
+        return;
+
+    auto backoff = pool.backoff_ms == 0
+        ? BREAKER_INITIAL_BACKOFF_MS
+        : std::min(pool.backoff_ms * 2, BREAKER_MAX_BACKOFF_MS);
+    auto jitter = 1. + BREAKER_JITTER * (2 * QRandomGenerator::global()->generateDouble() - 1);
+
+    pool.backoff_ms = static_cast<int>(backoff * jitter);
+    pool.breaker_opened.start();
+    set_breaker(host, BreakerState::Open);
+}
+
+void NetworkService::set_breaker(const QString &host, BreakerState state) {
+    auto & stats = _hosts[host].stats;
+    if (stats.breaker == state)
+        return;
+
+    stats.breaker = state;
+    emit breaker_changed(host, state);
+}
+
+void NetworkService::enqueue(const QString &host, int priority, Dispatch dispatch) {
+    auto & pool = _hosts[host];
+    pool.stats.requests += 1;
+    pool.queues[priority].enqueue(dispatch);
+    pump(host);
+}
+
+void NetworkService::pump(const QString &host) {
+    auto & pool = _hosts[host];
+
+    auto next_class = [&] {
+        for (int priority = 0; priority < PRIORITY_COUNT; ++priority) {
+            auto limit = MAX_IN_FLIGHT_PER_CLASS[priority];
+            auto has_room = limit == 0 || _class_in_flight[priority] < limit;
+
+            if (has_room && !pool.queues[priority].isEmpty())
+                return priority;
+        }
+        return -1;
+    };
+
+    auto max_in_flight = pool.http2 ? MAX_IN_FLIGHT_PER_HTTP2_HOST : MAX_IN_FLIGHT_PER_HOST;
+
+    while (pool.stats.in_flight < max_in_flight) {
+        auto priority = next_class();
+        if (priority < 0)
+            break;
+
+        auto dispatch = pool.queues[priority].dequeue();
+
+        if (dispatch()) {
+            pool.stats.in_flight += 1;
+            _class_in_flight[priority] += 1;
+        }
+    }
+}
+
+void NetworkService::release(const QString &host, int priority) {
+    _hosts[host].stats.in_flight -= 1;
+    _class_in_flight[priority] -= 1;
+
+    pump(host);
+
+    // The freed class slot can go to a request waiting on another host
+    if (MAX_IN_FLIGHT_PER_CLASS[priority] != 0) {
+        for (auto & other_host: _hosts.keys())
+            pump(other_host);
+    }
+}
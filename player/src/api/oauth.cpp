@@ -1,14 +1,14 @@
 #include "api/oauth.hpp"
 
+#include "api/network.hpp"
+
 #include "constants.hpp"
 
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QHostAddress>
 
-#include <QNetworkAccessManager>
 #include <QNetworkRequest>
-#include <QNetworkReply>
 #include <QUrlQuery>
 
 #include <QJsonDocument>
@@ -16,6 +16,7 @@
 #include <QJsonArray>
 
 #include <QSettings>
+#include <QDateTime>
 
 #include <QDesktopServices>
 
@@ -101,10 +102,13 @@ QPromise<QString> OAuth::query_token() {
     else
         QDesktopServices::openUrl(authorize_url());
 
-    return QPromise<QString>([=](const auto & resolve, auto) {
+    return QPromise<QString>([=](const auto & resolve, const auto & reject) {
         QObject::connect(this, &OAuth::token_ready, [=](auto token) {
             resolve(token);
         });
+        QObject::connect(this, &OAuth::token_failed, [=] {
+            reject(QNetworkReply::AuthenticationRequiredError);
+        });
     });
 }
 
@@ -115,29 +119,38 @@ void OAuth::save_token_data(const QByteArray &raw_data) {
 
     auto access_token = json_data["access_token"].toString();
     auto refresh_token = json_data["refresh_token"].toString();
+    auto expires_in = json_data["expires_in"].toInt();
+
+    if (access_token.isEmpty()) {
+        emit token_failed();
+        return;
+    }
 
     QSettings settings;
 
     settings.setValue(ACCESS_TOKEN_KEY, access_token);
     settings.setValue(REFRESH_TOKEN_KEY, refresh_token);
 
+    // Tokens that do not expire come without a lifetime
+    if (expires_in > 0)
+        settings.setValue(EXPIRES_AT_KEY, QDateTime::currentDateTimeUtc().addSecs(expires_in));
+    else
+        settings.remove(EXPIRES_AT_KEY);
+
     emit token_ready(access_token);
 }
 
 void OAuth::fetch_token(const QUrl &url) {
-    auto http_client = new QNetworkAccessManager(this);
-    auto token_reply = http_client->post(QNetworkRequest { url }, QByteArray());
+    QNetworkRequest request { url };
+    request.setAttribute(ENDPOINT_ATTRIBUTE, "oauth_token");
+    request.setAttribute(PRIORITY_ATTRIBUTE, static_cast<int>(Priority::Interactive));
 
-    QObject::connect(token_reply, &QNetworkReply::finished, [=] {
-        auto status = token_reply
-            ->attribute(QNetworkRequest::HttpStatusCodeAttribute)
-            .toInt();
-
-        if (status == 200) {
-            auto token_data = token_reply->readAll();
+    NetworkService::instance()
+        .fetch(request, "POST")
+        .then([=](const QByteArray &token_data) {
             save_token_data(token_data);
-        }
-
-        token_reply->deleteLater();
-    });
+        })
+        .fail([=] {
+            emit token_failed();
+        });
 }
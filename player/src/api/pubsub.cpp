@@ -1,14 +1,34 @@
 #include "api/pubsub.hpp"
+#include "api/metrics.hpp"
+
+#include "constants.hpp"
 
 #include <QWebSocket>
 #include <QTimer>
+#include <QSettings>
+#include <QRandomGenerator>
 
 #include <QJsonDocument>
 #include <QJsonArray>
 
 #include "prelude/timer.hpp"
 
-constexpr auto WS_URL = "wss://pubsub-edge.twitch.tv";
+#include <algorithm>
+
+// Twitch refuses more topics than that on a single connection
+constexpr auto MAX_TOPICS_PER_SHARD = 50;
+constexpr auto BATCH_DELAY_MS = 50;
+
+// Twitch asks for a PING at least every 5 minutes, and expects clients to
+// reconnect when the PONG does not come within 10 seconds
+constexpr auto PING_INTERVAL_MS = 4 * 60 * 1000;
+constexpr auto PING_JITTER_MS = 10'000;
+constexpr auto PONG_TIMEOUT_MS = 10'000;
+
+// Doubled after every failed reconnection
+constexpr auto INITIAL_RECONNECT_DELAY_MS = 1'000;
+constexpr auto MAX_RECONNECT_DELAY_MS = 120'000;
+constexpr auto RECONNECT_JITTER = 0.2;
 
 static QString gen_nonce() {
     const QString charset {
@@ -41,12 +61,6 @@ struct ListenOrder {
             { "topics", QJsonArray::fromStringList(topics) }
         };
     }
-
-    static ListenOrder playback(QString channel) {
-        auto playback_topic = QString("video-playback.%1").arg(channel);
-
-        return { QStringList() << playback_topic };
-    }
 };
 
 struct UnlistenOrder {
@@ -59,14 +73,12 @@ struct UnlistenOrder {
             { "topics", QJsonArray::fromStringList(topics) }
         };
     }
-
-    static UnlistenOrder playback(QString channel) {
-        auto playback_topic = QString("video-playback.%1").arg(channel);
-
-        return { QStringList() << playback_topic };
-    }
 };
 
+static QString playback_topic(const QString &channel) {
+    return QString("video-playback.%1").arg(channel);
+}
+
 template <class Order>
 static QJsonObject encode_order(Order order, QString nonce) {
     return {
@@ -77,76 +89,210 @@ static QJsonObject encode_order(Order order, QString nonce) {
 }
 
 TwitchPubSub::TwitchPubSub(QObject *parent):
-    QObject(parent),
-    _ws(new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this)),
-    _ping_timer(new QTimer(this))
+    QObject(parent)
 {
-    QObject::connect(_ws, &QWebSocket::connected, [this] {
-        _ping_timer->start();
+    using namespace constants::settings::notifications;
+
+    QSettings settings;
+    _url = settings.value(KEY_PUBSUB_URL, DEFAULT_PUBSUB_URL).toString();
+
+    // Listens issued in a burst (e.g. every monitored channel at startup)
+    // go out as a few multi-topic orders rather than one order each
+    _schedule_flush = debounced(this, BATCH_DELAY_MS, [this] { flush_orders(); });
+}
+
+QtPromise::QPromise<void> TwitchPubSub::listen_to_channel(QString channel) {
+    if (_listeners[channel]++ > 0)
+        return QtPromise::QPromise<void>::resolve();
+
+    auto topic = playback_topic(channel);
+    auto & shard = shard_with_room();
+
+    shard.topics.insert(topic);
+    shard.pending_unlistens.removeOne(topic);
+    shard.pending_listens << topic;
+    _topic_shards.insert(topic, &shard);
+
+    auto promise = QtPromise::QPromise<void>([=](auto resolve, auto reject) {
+        _pending_topics.insert(topic, PendingOrder { resolve, reject });
+    });
+
+    _schedule_flush();
+
+    return promise;
+}
+
+void TwitchPubSub::unlisten_to_channel(QString channel) {
+    auto listeners_it = _listeners.find(channel);
+    if (listeners_it == _listeners.end())
+        return;
+
+    if (--*listeners_it > 0)
+        return;
+    _listeners.erase(listeners_it);
+
+    auto topic = playback_topic(channel);
+    auto shard = _topic_shards.take(topic);
+    if (!shard)
+        return;
+
+    shard->topics.remove(topic);
+
+    // Never sent: there is nothing to take back
+    if (shard->pending_listens.removeOne(topic))
+        settle_topic(topic, { });
+    else {
+        shard->pending_unlistens << topic;
+        _schedule_flush();
+    }
+}
+
+PubSubShard & TwitchPubSub::shard_with_room() {
+    for (auto & shard: _shards) {
+        if (shard->topics.size() < MAX_TOPICS_PER_SHARD)
+            return *shard;
+    }
 
-        for (auto order: _order_queue)
-            send_message(order);
+    auto shard = std::make_unique<PubSubShard>();
+    shard->ws = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+    shard->ping_timer = new QTimer(this);
+    shard->pong_timer = new QTimer(this);
+    shard->reconnect_timer = new QTimer(this);
 
-        _order_queue.clear();
+    connect_shard(*shard);
+    _shards.push_back(std::move(shard));
+
+    return *_shards.back();
+}
+
+void TwitchPubSub::connect_shard(PubSubShard &shard) {
+    auto shard_ptr = &shard;
+
+    QObject::connect(shard.ws, &QWebSocket::connected, this, [=] {
+        shard_ptr->reconnect_attempts = 0;
+        shard_ptr->ping_timer->start();
+
+        // Nothing to listen to again
+        if (shard_ptr->topics.isEmpty())
+            shard_ptr->down_since.invalidate();
+
+        flush_orders();
     });
 
-    QObject::connect(_ws, &QWebSocket::disconnected, [this] {
-        _ping_timer->stop();
+    // Every shard reconnects on its own and listens to its topics again.
+    // Going back to the unconnected state covers both a connection that
+    // closed and an attempt that never got through (DNS, refused, TLS or
+    // handshake error), which does not emit `disconnected`
+    QObject::connect(shard.ws, &QWebSocket::stateChanged, this, [=](QAbstractSocket::SocketState state) {
+        if (state != QAbstractSocket::UnconnectedState || shard_ptr->reconnect_timer->isActive())
+            return;
+
+        shard_ptr->ping_timer->stop();
+        shard_ptr->pong_timer->stop();
+
+        // Only the first of several attempts in a row counts as a reconnection
+        if (!shard_ptr->down_since.isValid()) {
+            ApiMetrics::instance().record_pubsub_reconnect(shard_ptr->pong_timed_out);
+            shard_ptr->down_since.start();
+        }
+        shard_ptr->pong_timed_out = false;
+
+        for (auto it = _pending_orders.begin(); it != _pending_orders.end();) {
+            if (it->shard == shard_ptr)
+                it = _pending_orders.erase(it);
+            else
+                ++it;
+        }
 
-        _order_queue = _orders_issued;
-        _orders_issued.clear();
+        shard_ptr->pending_unlistens.clear();
+        shard_ptr->pending_listens = shard_ptr->topics.values();
+
+        shard_ptr->reconnect_timer->start(reconnect_delay_ms(shard_ptr->reconnect_attempts++));
+    });
 
-        delayed(this, 2000, [this] { _ws->open(QUrl { WS_URL }); });
+    QObject::connect(shard.reconnect_timer, &QTimer::timeout, this, [=] {
+        shard_ptr->ws->open(_url);
     });
 
-    QObject::connect(_ws, &QWebSocket::textMessageReceived, [this](auto raw_message) {
+    QObject::connect(shard.ws, &QWebSocket::textMessageReceived, this, [=](auto raw_message) {
         auto message = QJsonDocument::fromJson(raw_message.toLocal8Bit());
-        process_message(message.object());
+        process_message(*shard_ptr, message.object());
     });
 
-    QObject::connect(_ping_timer, &QTimer::timeout, [this] {
-        send_message(ping_message());
+    QObject::connect(shard.ping_timer, &QTimer::timeout, this, [=] {
+        send_message(*shard_ptr, ping_message());
+        shard_ptr->pong_timer->start();
     });
 
-    _ping_timer->setInterval(4 * 60 * 1000);
+    QObject::connect(shard.pong_timer, &QTimer::timeout, this, [=] {
+        shard_ptr->pong_timed_out = true;
+        shard_ptr->ws->abort();
+    });
+
+    // Shards opened together should not all ping at once
+    shard.ping_timer->setInterval(
+        PING_INTERVAL_MS - QRandomGenerator::global()->bounded(PING_JITTER_MS)
+    );
+    shard.pong_timer->setSingleShot(true);
+    shard.pong_timer->setInterval(PONG_TIMEOUT_MS);
+    shard.reconnect_timer->setSingleShot(true);
 
-    _ws->open(QUrl { WS_URL });
+    shard.ws->open(_url);
 }
 
-QtPromise::QPromise<void> TwitchPubSub::listen_to_channel(QString channel) {
-    auto listen_order = ListenOrder::playback(channel);
-    auto nonce = gen_nonce();
+int TwitchPubSub::reconnect_delay_ms(int attempts) const {
+    auto exponent = std::min(attempts, 16);
+    auto delay = std::min<qint64>(MAX_RECONNECT_DELAY_MS, qint64(INITIAL_RECONNECT_DELAY_MS) << exponent);
+    auto jitter = 1. + RECONNECT_JITTER * (2 * QRandomGenerator::global()->generateDouble() - 1);
 
-    auto promise = QtPromise::QPromise<void>([=](auto resolve, auto reject) {
-        _pending_orders.insert(nonce, PendingOrder { resolve, reject });
-    });
+    return static_cast<int>(delay * jitter);
+}
 
-    auto order_message = encode_order(listen_order, nonce);
+void TwitchPubSub::flush_orders() {
+    for (auto & shard: _shards) {
+        if (shard->ws->state() != QAbstractSocket::SocketState::ConnectedState)
+            continue;
 
-    if (_ws->state() != QAbstractSocket::SocketState::ConnectedState) {
-        _order_queue.append(order_message);
-    } else {
-        send_message(order_message);
-    }
+        if (!shard->pending_unlistens.isEmpty()) {
+            UnlistenOrder unlisten_order { shard->pending_unlistens };
+            send_message(*shard, encode_order(unlisten_order, gen_nonce()));
 
-    return promise;
+            shard->pending_unlistens.clear();
+        }
+
+        // A shard never holds more topics than a single order may carry
+        if (!shard->pending_listens.isEmpty()) {
+            auto nonce = gen_nonce();
+
+            ListenOrder listen_order { shard->pending_listens };
+            _pending_orders.insert(nonce, PendingBatch { shard.get(), shard->pending_listens });
+            send_message(*shard, encode_order(listen_order, nonce));
+
+            shard->pending_listens.clear();
+        }
+    }
 }
 
-void TwitchPubSub::unlisten_to_channel(QString channel) {
-    auto unlisten_order = UnlistenOrder::playback(channel);
+void TwitchPubSub::settle_topic(const QString &topic, const QString &error) {
+    auto pending_topic_it = _pending_topics.find(topic);
+    if (pending_topic_it == _pending_topics.end())
+        return;
 
-    auto order_message = encode_order(unlisten_order, gen_nonce());
+    if (error.isEmpty())
+        pending_topic_it->resolve();
+    else
+        pending_topic_it->reject(error);
 
-    send_message(order_message);
+    _pending_topics.erase(pending_topic_it);
 }
 
-void TwitchPubSub::send_message(QJsonObject message) {
+void TwitchPubSub::send_message(PubSubShard &shard, QJsonObject message) {
     // qDebug() << ">>" << message;
 
-    _ws->sendTextMessage(QJsonDocument(message).toJson());
+    shard.ws->sendTextMessage(QJsonDocument(message).toJson());
 }
 
-void TwitchPubSub::process_message(QJsonObject message) {
+void TwitchPubSub::process_message(PubSubShard &shard, QJsonObject message) {
     // qDebug() << "<<" << message;
 
     auto type = message["type"].toString();
@@ -158,14 +304,24 @@ void TwitchPubSub::process_message(QJsonObject message) {
         if (pending_order_it != _pending_orders.end()) {
             auto error = message["error"].toString();
 
-            if (error.isEmpty())
-                pending_order_it->resolve();
-            else
-                pending_order_it->reject(error);
+            for (auto & topic: pending_order_it->topics)
+                settle_topic(topic, error);
 
-            _pending_orders.remove(nonce);
+            if (shard.down_since.isValid()) {
+                ApiMetrics::instance().record_pubsub_resubscribe(shard.down_since.elapsed());
+                shard.down_since.invalidate();
+            }
+
+            _pending_orders.erase(pending_order_it);
         }
     }
+    else if (type == "PONG") {
+        shard.pong_timer->stop();
+    }
+    else if (type == "RECONNECT") {
+        // The edge is going away: the disconnection handler takes over
+        shard.ws->close();
+    }
     else if (type == "MESSAGE") {
         auto data = message["data"].toObject();
         auto topic = data["topic"].toString();
@@ -180,5 +336,8 @@ void TwitchPubSub::process_message(QJsonObject message) {
         else if (data_message_type == "stream-down") {
             emit channel_went_offline(channel);
         }
+        else if (data_message_type == "viewcount") {
+            emit viewcount_changed(channel, data_message["viewers"].toInt());
+        }
     }
 }
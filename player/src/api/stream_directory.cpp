@@ -0,0 +1,410 @@
+#include "api/stream_directory.hpp"
+#include "api/pubsub.hpp"
+#include "api/token_manager.hpp"
+
+#include "prelude/timer.hpp"
+
+#include "constants.hpp"
+
+#include <QSettings>
+#include <QTimer>
+
+constexpr auto TOP_STREAMS_TTL_MS = 2 * 60 * 1000;
+// Followed streams are pushed as they go up or down, the whole listing is
+// only reconciled once in a while, to catch what the events missed
+constexpr auto FOLLOWED_STREAMS_TTL_MS = 10 * 60 * 1000;
+constexpr auto FOLLOWED_CHANNELS_PAGE_SIZE = 100;
+// The API can lag behind PubSub and not have the stream yet
+constexpr auto STREAM_UP_RETRY_DELAY_MS = 15 * 1000;
+constexpr auto MAX_STREAM_UP_RETRIES = 3;
+constexpr auto SEARCH_TTL_MS = 30 * 1000;
+// Search results nobody is watching that are kept around, for when the
+// search box goes back to a previous query
+constexpr auto MAX_IDLE_SEARCHES = 16;
+// Channels of the listings that get their viewer counts pushed, cards beyond
+// that keep being refreshed with the listing. Every channel is a topic of a
+// PubSub connection, which only accepts so many
+constexpr auto MAX_PUSHED_VIEWCOUNTS = 40;
+// A channel whose viewer count nobody watches anymore is only unlistened to
+// after a while, in case it comes back
+constexpr auto VIEWCOUNT_UNLISTEN_DELAY_MS = 5 * 1000;
+
+static const QString SEARCH_PREFIX = "search:";
+
+StreamDirectory::StreamDirectory(TwitchPubSub &pubsub, QObject *parent):
+    QObject(parent),
+    _pubsub(pubsub)
+{
+    seed_channels();
+
+    QObject::connect(&_pubsub, &TwitchPubSub::channel_went_live, this, [=](QString channel) {
+        followed_went_live(channel);
+    });
+
+    QObject::connect(&_pubsub, &TwitchPubSub::channel_went_offline, this, [=](QString channel) {
+        if (_followed_channels.contains(channel))
+            remove_stream(followed_key(), channel);
+    });
+
+    QObject::connect(&_pubsub, &TwitchPubSub::viewcount_changed, this, [=](QString channel, int viewers) {
+        update_viewcount(channel, viewers);
+    });
+
+    // Logging in, possibly as someone else
+    QObject::connect(&TokenManager::instance(), &TokenManager::token_changed, this, [=] {
+        reconcile_followed();
+    });
+
+    track_followed();
+    interval(this, FOLLOWED_STREAMS_TTL_MS, [=] { reconcile_followed(); });
+}
+
+StreamDirectory::~StreamDirectory() {
+    for (auto & listing: _listings) {
+        if (listing.pending)
+            listing.pending->cancel();
+    }
+}
+
+QString StreamDirectory::top_key() {
+    return "top";
+}
+
+QString StreamDirectory::followed_key() {
+    return "followed";
+}
+
+QString StreamDirectory::search_key(const QString &query) {
+    return SEARCH_PREFIX + query;
+}
+
+void StreamDirectory::watch(const QString &key) {
+    _listings[key].watchers += 1;
+
+    if (key.startsWith(SEARCH_PREFIX)) {
+        _search_history.removeAll(key);
+        _search_history.append(key);
+    }
+
+    revalidate(key);
+}
+
+void StreamDirectory::unwatch(const QString &key) {
+    auto listing_it = _listings.find(key);
+    if (listing_it == _listings.end())
+        return;
+
+    listing_it->watchers = std::max(0, listing_it->watchers - 1);
+
+    if (listing_it->watchers == 0 && listing_it->pending) {
+        listing_it->pending->cancel();
+        listing_it->pending.reset();
+    }
+
+    evict_searches();
+}
+
+const QList<QList<StreamData>> & StreamDirectory::pages(const QString &key) {
+    return _listings[key].pages;
+}
+
+void StreamDirectory::request_page(const QString &key, int index) {
+    auto & listing = _listings[key];
+
+    if (index < listing.pages.size() || listing.complete || listing.pending)
+        return;
+
+    fetch(key, index);
+}
+
+ChannelIndex & StreamDirectory::channels() {
+    return _channels;
+}
+
+// Channels known before any listing comes in: those played at least once
+// (which have a quality remembered) and those monitored for notifications
+void StreamDirectory::seed_channels() {
+    using namespace constants::settings;
+
+    QSettings settings;
+
+    settings.beginGroup(streams::GROUP_LAST_QUALITY);
+    for (auto & channel: settings.childKeys())
+        _channels.insert(channel, ChannelIndex::Source::Watched);
+    settings.endGroup();
+
+    auto monitored = settings
+        .value(notifications::KEY_PUBSUB_CHANNELS, notifications::DEFAULT_PUBSUB_CHANNELS)
+        .toStringList();
+    for (auto & channel: monitored)
+        _channels.insert(channel, ChannelIndex::Source::Monitored);
+}
+
+bool StreamDirectory::watch_viewcount(const QString &channel, bool capped) {
+    auto watched = _viewcount_watchers.contains(channel);
+    if (capped && !watched && _viewcount_watchers.size() >= MAX_PUSHED_VIEWCOUNTS)
+        return false;
+
+    _viewcount_watchers[channel] += 1;
+
+    // Viewer counts come on the playback topic
+    if (!_viewcount_listened.contains(channel)) {
+        _viewcount_listened.insert(channel);
+        _pubsub.listen_to_channel(channel);
+    }
+
+    return true;
+}
+
+void StreamDirectory::unwatch_viewcount(const QString &channel) {
+    auto watchers_it = _viewcount_watchers.find(channel);
+    if (watchers_it == _viewcount_watchers.end())
+        return;
+
+    *watchers_it -= 1;
+    if (*watchers_it > 0)
+        return;
+
+    _viewcount_watchers.erase(watchers_it);
+
+    // Listings that get reset present mostly the same channels again
+    QTimer::singleShot(VIEWCOUNT_UNLISTEN_DELAY_MS, this, [=] {
+        if (_viewcount_watchers.contains(channel) || !_viewcount_listened.remove(channel))
+            return;
+
+        _pubsub.unlisten_to_channel(channel);
+    });
+}
+
+void StreamDirectory::track_followed() {
+    TokenManager::instance().valid_token()
+        .then([=](QString access_token) {
+            if (access_token.isEmpty())
+                return;
+
+            _api.current_user(access_token)
+                .then([=](ChannelData user) {
+                    collect_followed(user.id, 0, { });
+                });
+        });
+}
+
+void StreamDirectory::collect_followed(uint32_t user_id, int offset,
+                                       QHash<QString, uint32_t> collected)
+{
+    _api.followed_channels(user_id, Page { offset, FOLLOWED_CHANNELS_PAGE_SIZE })
+        .then([=](QList<ChannelData> channels) mutable {
+            for (auto & channel: channels)
+                collected.insert(channel.name, channel.id);
+
+            if (channels.size() < FOLLOWED_CHANNELS_PAGE_SIZE)
+                update_followed(collected);
+            else
+                collect_followed(user_id, offset + channels.size(), collected);
+        });
+}
+
+void StreamDirectory::update_followed(const QHash<QString, uint32_t> &followed) {
+    for (auto it = followed.begin(); it != followed.end(); ++it) {
+        if (!_followed_channels.contains(it.key()))
+            _pubsub.listen_to_channel(it.key());
+
+        _channels.insert(it.key(), ChannelIndex::Source::Followed);
+    }
+
+    for (auto it = _followed_channels.begin(); it != _followed_channels.end(); ++it) {
+        if (!followed.contains(it.key()))
+            _pubsub.unlisten_to_channel(it.key());
+    }
+
+    _followed_channels = followed;
+}
+
+void StreamDirectory::followed_went_live(const QString &channel, int attempt) {
+    auto id_it = _followed_channels.find(channel);
+    if (id_it == _followed_channels.end())
+        return;
+
+    _api.stream(*id_it)
+        .then([=](StreamData stream) {
+            if (!stream.channel.name.isEmpty()) {
+                insert_stream(followed_key(), stream);
+                _channels.insert(stream, ChannelIndex::Source::Followed);
+            }
+            else if (attempt < MAX_STREAM_UP_RETRIES) {
+                delayed(this, STREAM_UP_RETRY_DELAY_MS, [=] {
+                    followed_went_live(channel, attempt + 1);
+                });
+            }
+        });
+}
+
+// Also picks up channels followed or unfollowed since the last time
+void StreamDirectory::reconcile_followed() {
+    track_followed();
+
+    // Unwatched listings get revalidated when watched again
+    auto & listing = _listings[followed_key()];
+    if (listing.watchers > 0 && !listing.pending)
+        fetch(followed_key(), 0);
+}
+
+// Streams are ordered by viewcount. One that would land after every loaded
+// page is left for the next page to bring, unless there is none
+void StreamDirectory::insert_stream(const QString &key, const StreamData &stream) {
+    remove_stream(key, stream.channel.name);
+
+    auto & listing = _listings[key];
+    if (listing.pages.isEmpty())
+        return;
+
+    auto position = 0;
+    for (auto & page: listing.pages) {
+        for (auto i = 0; i < page.size(); ++i, ++position) {
+            if (page[i].viewcount < stream.viewcount) {
+                page.insert(i, stream);
+                emit stream_added(key, position, stream);
+                return;
+            }
+        }
+    }
+
+    if (listing.complete) {
+        listing.pages.last() << stream;
+        emit stream_added(key, position, stream);
+    }
+}
+
+void StreamDirectory::remove_stream(const QString &key, const QString &channel) {
+    auto listing_it = _listings.find(key);
+    if (listing_it == _listings.end())
+        return;
+
+    for (auto & page: listing_it->pages) {
+        for (auto i = 0; i < page.size(); ++i) {
+            if (page[i].channel.name == channel) {
+                page.removeAt(i);
+                emit stream_removed(key, channel);
+                return;
+            }
+        }
+    }
+}
+
+// Listings keep their order: moving cards around on every push would be
+// more distracting than useful
+void StreamDirectory::update_viewcount(const QString &channel, int viewers) {
+    for (auto & listing: _listings) {
+        for (auto & page: listing.pages) {
+            for (auto & stream: page) {
+                if (stream.channel.name == channel)
+                    stream.viewcount = static_cast<uint32_t>(viewers);
+            }
+        }
+    }
+
+    emit viewcount_changed(channel, viewers);
+}
+
+TwitchAPI::streams_response_t StreamDirectory::query(const QString &key, Page page,
+                                                     CancelToken token)
+{
+    if (key == followed_key()) {
+        return TokenManager::instance().valid_token()
+            .then([=](QString access_token) {
+                return _api.followed_streams(access_token, page, token);
+            });
+    }
+
+    if (key.startsWith(SEARCH_PREFIX))
+        return _api.stream_search(key.mid(SEARCH_PREFIX.size()), page, token);
+
+    return _api.top_streams(page, token);
+}
+
+int StreamDirectory::time_to_live(const QString &key) const {
+    if (key == followed_key())
+        return FOLLOWED_STREAMS_TTL_MS;
+    if (key.startsWith(SEARCH_PREFIX))
+        return SEARCH_TTL_MS;
+    return TOP_STREAMS_TTL_MS;
+}
+
+// Stale listings are still presented, the fresh first page replaces them
+// when it arrives
+void StreamDirectory::revalidate(const QString &key) {
+    auto & listing = _listings[key];
+
+    auto stale = listing.age.isValid() && listing.age.hasExpired(time_to_live(key));
+    if (!stale || listing.pending)
+        return;
+
+    fetch(key, 0);
+}
+
+void StreamDirectory::fetch(const QString &key, int index) {
+    auto token = std::make_shared<Cancellable>();
+    _listings[key].pending = token;
+
+    // A cancelled token means that nobody watches the listing anymore (or
+    // that the directory is gone): the continuations must not touch it
+    auto store_page = [=](QList<StreamData> streams) {
+        if (token->cancelled())
+            return;
+
+        auto & listing = _listings[key];
+        listing.pending.reset();
+
+        auto replaces_listing = index == 0 && !listing.pages.isEmpty();
+
+        if (index == 0) {
+            listing.pages.clear();
+            listing.complete = false;
+            listing.age.start();
+        }
+
+        if (listing.pages.size() != index)
+            return;
+
+        listing.pages << streams;
+
+        auto source = key == followed_key()
+            ? ChannelIndex::Source::Followed
+            : ChannelIndex::Source::Directory;
+        for (auto & stream: streams)
+            _channels.insert(stream, source);
+        listing.complete = streams.size() < PAGE_SIZE;
+
+        if (replaces_listing)
+            emit listing_reset(key);
+        else
+            emit page_ready(key, index, streams);
+    };
+
+    auto release_pending = [=] {
+        if (token->cancelled())
+            return;
+
+        auto & listing = _listings[key];
+        if (listing.pending == token)
+            listing.pending.reset();
+    };
+
+    query(key, Page { index * PAGE_SIZE, PAGE_SIZE }, token)
+        .then(store_page)
+        .fail(release_pending);
+}
+
+void StreamDirectory::evict_searches() {
+    QStringList idle;
+    for (auto & key: _search_history) {
+        if (_listings.value(key).watchers == 0)
+            idle << key;
+    }
+
+    while (idle.size() > MAX_IDLE_SEARCHES) {
+        auto key = idle.takeFirst();
+        _search_history.removeAll(key);
+        _listings.remove(key);
+    }
+}
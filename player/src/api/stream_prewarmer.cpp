@@ -0,0 +1,120 @@
+#include "api/stream_prewarmer.hpp"
+#include "api/images.hpp"
+
+#include "constants.hpp"
+
+#include <QCoreApplication>
+#include <QSettings>
+
+#include <algorithm>
+
+constexpr auto MAX_PREWARMED_CHANNELS = 4;
+
+// As shown by the details overlay
+static const QSize LOGO_SIZE { 100, 100 };
+
+// Past the daemon's own cache of stream indexes, a prewarmed one is no
+// faster to play than a fresh lookup
+static qint64 prewarm_ttl_ms() {
+    using namespace constants::settings::daemon;
+    QSettings settings;
+
+    return settings.value(KEY_CACHE_TIMEOUT, DEFAULT_CACHE_TIMEOUT).toLongLong() * 1000;
+}
+
+StreamPrewarmer &StreamPrewarmer::instance() {
+    static auto prewarmer = new StreamPrewarmer(qApp);
+    return *prewarmer;
+}
+
+StreamPrewarmer::StreamPrewarmer(QObject *parent):
+    QObject(parent)
+{ }
+
+void StreamPrewarmer::prewarm(const QString &channel) {
+    using namespace constants::settings::notifications;
+
+    QSettings settings;
+    if (!settings.value(KEY_PREWARM_ON_GO_LIVE, DEFAULT_PREWARM_ON_GO_LIVE).toBool())
+        return;
+
+    evict_expired();
+
+    // Out of budget: a burst of go-live events should not flood the daemon
+    if (_prewarmed.contains(channel) || _prewarmed.size() >= MAX_PREWARMED_CHANNELS)
+        return;
+
+    _prewarmed[channel].age.start();
+
+    _daemon.stream_index(channel)
+        .then([=](StreamIndex index) {
+            auto prewarmed_it = _prewarmed.find(channel);
+            if (prewarmed_it != _prewarmed.end())
+                prewarmed_it->index = index;
+        })
+        // Frees the budget, unless the stream details made the entry
+        // worth keeping
+        .fail([=] {
+            auto prewarmed_it = _prewarmed.find(channel);
+            if (prewarmed_it != _prewarmed.end() && !prewarmed_it->stream)
+                _prewarmed.erase(prewarmed_it);
+        });
+
+    auto fetch_stream = [=](QList<ChannelData> channels) {
+        auto channel_it = std::find_if(
+            channels.begin(), channels.end(),
+            [=](ChannelData data) { return data.name == channel; }
+        );
+        if (channel_it != channels.end())
+            return _twitch.stream(channel_it->id);
+        else
+            return TwitchAPI::stream_response_t::reject("Channel not found");
+    };
+
+    _twitch.channel_search(channel)
+        .then(fetch_stream)
+        .then([=](StreamData stream) {
+            auto prewarmed_it = _prewarmed.find(channel);
+            if (prewarmed_it != _prewarmed.end())
+                prewarmed_it->stream = stream;
+
+            // Lands in the image cache the overlay looks into first
+            ImageService::instance().fetch(stream.channel.logo_url, LOGO_SIZE);
+        })
+        .fail([=] {
+            auto prewarmed_it = _prewarmed.find(channel);
+            if (prewarmed_it != _prewarmed.end() && !prewarmed_it->index)
+                _prewarmed.erase(prewarmed_it);
+        });
+}
+
+std::optional<StreamIndex> StreamPrewarmer::stream_index(const QString &channel) {
+    evict_expired();
+
+    auto prewarmed_it = _prewarmed.find(channel);
+    if (prewarmed_it == _prewarmed.end())
+        return std::nullopt;
+
+    return prewarmed_it->index;
+}
+
+std::optional<StreamData> StreamPrewarmer::stream(const QString &channel) {
+    evict_expired();
+
+    auto prewarmed_it = _prewarmed.find(channel);
+    if (prewarmed_it == _prewarmed.end())
+        return std::nullopt;
+
+    return prewarmed_it->stream;
+}
+
+void StreamPrewarmer::evict_expired() {
+    auto ttl_ms = prewarm_ttl_ms();
+
+    for (auto it = _prewarmed.begin(); it != _prewarmed.end();) {
+        if (it->age.hasExpired(ttl_ms))
+            it = _prewarmed.erase(it);
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,226 @@
+#include "api/thumbnail_store.hpp"
+
+#include "prelude/timer.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <atomic>
+#include <cstring>
+
+constexpr quint32 INDEX_MAGIC = 0x54484d42; // "THMB"
+constexpr quint32 INDEX_VERSION = 2;
+constexpr auto ATLAS_FORMAT = QImage::Format_ARGB32_Premultiplied;
+constexpr auto INDEX_SAVE_DELAY_MS = 2000;
+
+static QString store_directory() {
+    auto cache_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    auto directory = QDir(cache_dir).filePath("thumbnails");
+    QDir().mkpath(directory);
+    return directory;
+}
+
+// FNV-1a: has to be the same from one run to the next, unlike qHash
+static quint64 url_tag(const QString &url) {
+    quint64 hash = 14695981039346656037ull;
+
+    for (auto c: url) {
+        hash ^= c.unicode();
+        hash *= 1099511628211ull;
+    }
+
+    return hash ? hash : 1;
+}
+
+ThumbnailStore::ThumbnailStore(const QString &name, QSize slot_size,
+                               int capacity, QObject *parent):
+    QObject(parent),
+    _slot_size(slot_size),
+    _capacity(capacity),
+    _lock(QDir(store_directory()).filePath(name + ".lock")),
+    _atlas(QDir(store_directory()).filePath(name + ".atlas")),
+    _index_path(QDir(store_directory()).filePath(name + ".index")),
+    _slots(capacity)
+{
+    _schedule_index_save = debounced(this, INDEX_SAVE_DELAY_MS, [this] {
+        save_index();
+    });
+
+    open_atlas();
+
+    if (_pixels)
+        load_index();
+}
+
+ThumbnailStore::~ThumbnailStore() {
+    if (_mapped) {
+        save_index();
+        _atlas.unmap(_mapped);
+    }
+}
+
+qint64 ThumbnailStore::slot_bytes() const {
+    return static_cast<qint64>(_slot_size.width()) * _slot_size.height() * 4;
+}
+
+uchar *ThumbnailStore::slot_data(int slot) const {
+    return _pixels + slot * slot_bytes();
+}
+
+std::optional<QImage> ThumbnailStore::lookup(const QString &url) {
+    auto slot_it = _slot_by_url.find(url);
+
+    if (!_pixels || slot_it == _slot_by_url.end())
+        return std::nullopt;
+
+    // Overwritten since the index was last saved, or by a write that never
+    // completed
+    if (_tags[*slot_it] != url_tag(url)) {
+        _slots[*slot_it] = Slot { };
+        _slot_by_url.erase(slot_it);
+        return std::nullopt;
+    }
+
+    auto & slot = _slots[*slot_it];
+    slot.last_used = QDateTime::currentMSecsSinceEpoch();
+    _schedule_index_save();
+
+    // Wraps the mapped memory without copying it: the caller has to upload
+    // (or copy) the image before the slot gets reused
+    return QImage {
+        static_cast<const uchar *>(slot_data(*slot_it)),
+        slot.width, slot.height,
+        _slot_size.width() * 4,
+        ATLAS_FORMAT
+    };
+}
+
+void ThumbnailStore::store(const QString &url, const QImage &image) {
+    if (!_pixels || image.isNull())
+        return;
+
+    auto fitted = image.size().boundedTo(_slot_size) == image.size()
+        ? image.convertToFormat(ATLAS_FORMAT)
+        : image.scaled(_slot_size, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+               .convertToFormat(ATLAS_FORMAT);
+
+    auto slot_it = _slot_by_url.find(url);
+    auto slot_index = slot_it != _slot_by_url.end() ? *slot_it : pick_slot();
+
+    auto & slot = _slots[slot_index];
+    if (!slot.url.isEmpty() && slot.url != url)
+        _slot_by_url.remove(slot.url);
+
+    // Whatever the index on disk says, the slot no longer holds its
+    // previous image from here on
+    _tags[slot_index] = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto destination = slot_data(slot_index);
+    auto destination_stride = _slot_size.width() * 4;
+    auto row_bytes = fitted.width() * 4;
+
+    for (int y = 0; y < fitted.height(); ++y)
+        std::memcpy(destination + y * destination_stride, fitted.constScanLine(y), row_bytes);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    _tags[slot_index] = url_tag(url);
+
+    slot.url = url;
+    slot.width = fitted.width();
+    slot.height = fitted.height();
+    slot.last_used = QDateTime::currentMSecsSinceEpoch();
+    _slot_by_url.insert(url, slot_index);
+
+    _schedule_index_save();
+}
+
+// Least recently used slot, free slots having never been used at all
+int ThumbnailStore::pick_slot() const {
+    auto oldest = 0;
+
+    for (int i = 1; i < _slots.size(); ++i) {
+        if (_slots[i].last_used < _slots[oldest].last_used)
+            oldest = i;
+    }
+
+    return oldest;
+}
+
+void ThumbnailStore::open_atlas() {
+    auto tags_size = static_cast<qint64>(sizeof(quint64)) * _capacity;
+    auto atlas_size = tags_size + slot_bytes() * _capacity;
+
+    // Held by another instance of the player: writing into the same slots
+    // would mix both indexes up. Only dead owners get their lock taken over
+    _lock.setStaleLockTime(0);
+    if (!_lock.tryLock(0))
+        return;
+
+    if (!_atlas.open(QIODevice::ReadWrite))
+        return;
+
+    if (_atlas.size() != atlas_size && !_atlas.resize(atlas_size))
+        return;
+
+    _mapped = _atlas.map(0, atlas_size);
+    if (!_mapped)
+        return;
+
+    _tags = reinterpret_cast<quint64 *>(_mapped);
+    _pixels = _mapped + tags_size;
+}
+
+void ThumbnailStore::load_index() {
+    QFile index_file { _index_path };
+
+    if (!index_file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream { &index_file };
+
+    quint32 magic, version;
+    QSize slot_size;
+    qint32 capacity;
+    stream >> magic >> version >> slot_size >> capacity;
+
+    // With a different geometry the atlas content is meaningless
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION ||
+        slot_size != _slot_size || capacity != _capacity)
+    {
+        return;
+    }
+
+    for (int i = 0; i < _capacity && stream.status() == QDataStream::Ok; ++i) {
+        Slot slot;
+        stream >> slot.url >> slot.width >> slot.height >> slot.last_used;
+
+        auto valid = !slot.url.isEmpty()
+                  && slot.width > 0 && slot.width <= _slot_size.width()
+                  && slot.height > 0 && slot.height <= _slot_size.height();
+
+        if (valid) {
+            _slots[i] = slot;
+            _slot_by_url.insert(slot.url, i);
+        }
+    }
+}
+
+void ThumbnailStore::save_index() {
+    QSaveFile index_file { _index_path };
+
+    if (!index_file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream { &index_file };
+
+    stream << INDEX_MAGIC << INDEX_VERSION << _slot_size << static_cast<qint32>(_capacity);
+
+    for (auto & slot: _slots)
+        stream << slot.url << slot.width << slot.height << slot.last_used;
+
+    index_file.commit();
+}
@@ -0,0 +1,122 @@
+#include "api/token_manager.hpp"
+
+#include "api/oauth.hpp"
+
+#include "constants.hpp"
+
+#include <QCoreApplication>
+#include <QSettings>
+#include <QTimer>
+
+#include <algorithm>
+
+// Refreshes happen that long before the expiry
+constexpr auto EXPIRY_MARGIN_S = 5 * 60;
+constexpr auto MIN_REFRESH_DELAY_S = 30;
+constexpr auto MAX_REFRESH_DELAY_S = 24 * 60 * 60;
+
+TokenManager &TokenManager::instance() {
+    static auto manager = new TokenManager(qApp);
+    return *manager;
+}
+
+TokenManager::TokenManager(QObject *parent):
+    QObject(parent),
+    _refresh_timer(new QTimer(this))
+{
+    _refresh_timer->setSingleShot(true);
+    QObject::connect(_refresh_timer, &QTimer::timeout, [=] { refresh(); });
+
+    load();
+}
+
+QString TokenManager::access_token() const {
+    return _access_token;
+}
+
+QtPromise::QPromise<QString> TokenManager::valid_token() {
+    auto expiring = _expires_at.isValid()
+        && QDateTime::currentDateTimeUtc().secsTo(_expires_at) < EXPIRY_MARGIN_S;
+
+    auto usable = !_access_token.isEmpty() && !expiring;
+
+    if (usable || !has_refresh_token())
+        return QtPromise::QPromise<QString>::resolve(_access_token);
+
+    return refresh();
+}
+
+QtPromise::QPromise<QString> TokenManager::refresh() {
+    if (_refresh)
+        return *_refresh;
+
+    // Refreshing must never end up in the browser, only a login does
+    if (!has_refresh_token())
+        return QtPromise::QPromise<QString>::resolve(_access_token);
+
+    auto oauth = new OAuth(this);
+
+    auto refresh = oauth->query_token()
+        .then([=](QString) {
+            load();
+            return _access_token;
+        })
+        .finally([=] {
+            oauth->deleteLater();
+            _refresh.reset();
+        });
+
+    _refresh = refresh;
+
+    return refresh;
+}
+
+void TokenManager::login() {
+    using namespace constants::settings::oauth;
+
+    {
+        QSettings settings;
+
+        settings.remove(ACCESS_TOKEN_KEY);
+        settings.remove(REFRESH_TOKEN_KEY);
+        settings.remove(EXPIRES_AT_KEY);
+    }
+
+    load();
+
+    auto oauth = new OAuth(this);
+    oauth->query_token()
+        .then([=](QString) { load(); })
+        .finally([=] { oauth->deleteLater(); });
+}
+
+bool TokenManager::has_refresh_token() const {
+    QSettings settings;
+
+    return !settings
+        .value(constants::settings::oauth::REFRESH_TOKEN_KEY)
+        .toString()
+        .isEmpty();
+}
+
+void TokenManager::load() {
+    using namespace constants::settings::oauth;
+
+    QSettings settings;
+
+    auto previous_token = _access_token;
+
+    _access_token = settings.value(ACCESS_TOKEN_KEY).toString();
+    _expires_at = settings.value(EXPIRES_AT_KEY).toDateTime();
+
+    _refresh_timer->stop();
+    if (!_access_token.isEmpty() && _expires_at.isValid()) {
+        auto delay = QDateTime::currentDateTimeUtc().secsTo(_expires_at) - EXPIRY_MARGIN_S;
+        delay = std::clamp<qint64>(delay, MIN_REFRESH_DELAY_S, MAX_REFRESH_DELAY_S);
+
+        _refresh_timer->start(static_cast<int>(delay * 1000));
+    }
+
+    if (_access_token != previous_token)
+        emit token_changed(_access_token);
+}
@@ -1,6 +1,6 @@
 #include "api/twitch.hpp"
 
-#include "api/oauth.hpp"
+#include "api/token_manager.hpp"
 
 #include "constants.hpp"
 
@@ -16,7 +16,8 @@ static ChannelData extract_channel(const QJsonObject & channel_obj) {
         channel_obj["display_name"].toString(),
         channel_obj["status"].toString(),
         channel_obj["logo"].toString(),
-        static_cast<uint32_t>(channel_obj["_id"].toInt())
+        // Numeric for channels, a string for users
+        channel_obj["_id"].toVariant().toUInt()
     };
 }
 
@@ -58,43 +59,59 @@ static QList<ChannelData> parse_channels_data(const QByteArray & raw) {
     return parsed;
 }
 
-TwitchAPI::streams_response_t TwitchAPI::stream_search(QString query) {
+static QList<ChannelData> parse_follows_data(const QByteArray & raw) {
+    QList<ChannelData> parsed;
+    auto json_data = QJsonDocument::fromJson(raw).object();
+
+    for (auto raw_follow: json_data["follows"].toArray())
+        parsed << extract_channel(raw_follow.toObject()["channel"].toObject());
+
+    return parsed;
+}
+
+static ChannelData parse_user_data(const QByteArray & raw) {
+    return extract_channel(QJsonDocument::fromJson(raw).object());
+}
+
+TwitchAPI::streams_response_t TwitchAPI::stream_search(QString query, Page page, CancelToken token) {
     QUrl url { "https://api.twitch.tv/kraken/search/streams" };
 
     QUrlQuery url_query;
     url_query.addQueryItem("q", query);
-    url_query.addQueryItem("offset", "0");
-    url_query.addQueryItem("limit", "32");
+    url_query.addQueryItem("offset", QString::number(page.offset));
+    url_query.addQueryItem("limit", QString::number(page.limit));
     url.setQuery(url_query);
 
     QNetworkRequest request { url };
     // request.setRawHeader("Accept", "application/vnd.twitchtv.v5+json");
     request.setRawHeader("Client-ID", constants::TWITCHD_CLIENT_ID);
 
-    return get(request).then(&parse_streams_data);
+    return get("stream_search", request, token)
+        .then(offloaded_parser("stream_search", &parse_streams_data));
 }
 
-TwitchAPI::streams_response_t TwitchAPI::top_streams() {
+TwitchAPI::streams_response_t TwitchAPI::top_streams(Page page, CancelToken token) {
     QUrl url { "https://api.twitch.tv/kraken/streams" };
 
     QUrlQuery url_query;
-    url_query.addQueryItem("offset", "0");
-    url_query.addQueryItem("limit", "32");
+    url_query.addQueryItem("offset", QString::number(page.offset));
+    url_query.addQueryItem("limit", QString::number(page.limit));
     url.setQuery(url_query);
 
     QNetworkRequest request { url };
     request.setRawHeader("Accept", "application/vnd.twitchtv.v5+json");
     request.setRawHeader("Client-ID", constants::TWITCHD_CLIENT_ID);
 
-    return get(request).then(&parse_streams_data);
+    return get("top_streams", request, token)
+        .then(offloaded_parser("top_streams", &parse_streams_data));
 }
 
-TwitchAPI::streams_response_t TwitchAPI::followed_streams(const QString & token) {
+TwitchAPI::streams_response_t TwitchAPI::followed_streams(const QString & token, Page page, CancelToken cancel_token) {
     QUrl url { "https://api.twitch.tv/kraken/streams/followed" };
 
     QUrlQuery url_query;
-    url_query.addQueryItem("offset", "0");
-    url_query.addQueryItem("limit", "32");
+    url_query.addQueryItem("offset", QString::number(page.offset));
+    url_query.addQueryItem("limit", QString::number(page.limit));
     url.setQuery(url_query);
 
     QNetworkRequest request { url };
@@ -104,18 +121,19 @@ TwitchAPI::streams_response_t TwitchAPI::followed_streams(const QString & token)
 
     auto retry_if_unauthorized = [=](QNetworkReply::NetworkError error) {
         if (error == QNetworkReply::AuthenticationRequiredError) {
-            auto oauth = std::make_shared<OAuth>();
-            return oauth->query_token().then([=](QString token) mutable {
-                oauth.reset();
-                return followed_streams(token);
+            return TokenManager::instance().refresh().then([=](QString refreshed) {
+                // Nothing better to offer: do not loop on the same refusal
+                if (refreshed.isEmpty() || refreshed == token)
+                    return streams_response_t::reject(error);
+                return followed_streams(refreshed, page, cancel_token);
             });
         }
         else
             return streams_response_t::reject(error);
     };
 
-    return get(request)
-        .then(&parse_streams_data)
+    return get("followed_streams", request, cancel_token)
+        .then(offloaded_parser("followed_streams", &parse_streams_data))
         .fail(retry_if_unauthorized);
 }
 
@@ -125,8 +143,10 @@ TwitchAPI::stream_response_t TwitchAPI::stream(uint32_t channel_id) {
     QNetworkRequest request { url };
     request.setRawHeader("Accept", "application/vnd.twitchtv.v5+json");
     request.setRawHeader("Client-ID", constants::TWITCHD_CLIENT_ID);
+    request.setAttribute(HEDGE_ATTRIBUTE, true);
 
-    return get(request).then(&parse_stream_data);
+    return get("stream", request)
+        .then(offloaded_parser("stream", &parse_stream_data));
 }
 
 TwitchAPI::channels_response_t TwitchAPI::channel_search(const QString &channel_name) {
@@ -142,5 +162,34 @@ TwitchAPI::channels_response_t TwitchAPI::channel_search(const QString &channel_
     request.setRawHeader("Accept", "application/vnd.twitchtv.v5+json");
     request.setRawHeader("Client-ID", constants::TWITCHD_CLIENT_ID);
 
-    return get(request).then(&parse_channels_data);
+    return get("channel_search", request)
+        .then(offloaded_parser("channel_search", &parse_channels_data));
+}
+
+TwitchAPI::channels_response_t TwitchAPI::followed_channels(uint32_t user_id, Page page, CancelToken token) {
+    QUrl url { QString("https://api.twitch.tv/kraken/users/%1/follows/channels").arg(user_id) };
+
+    QUrlQuery url_query;
+    url_query.addQueryItem("offset", QString::number(page.offset));
+    url_query.addQueryItem("limit", QString::number(page.limit));
+    url.setQuery(url_query);
+
+    QNetworkRequest request { url };
+    request.setRawHeader("Accept", "application/vnd.twitchtv.v5+json");
+    request.setRawHeader("Client-ID", constants::TWITCHD_CLIENT_ID);
+
+    return get("followed_channels", request, token)
+        .then(offloaded_parser("followed_channels", &parse_follows_data));
+}
+
+TwitchAPI::user_response_t TwitchAPI::current_user(const QString & token) {
+    QUrl url { "https://api.twitch.tv/kraken/user" };
+
+    QNetworkRequest request { url };
+    request.setRawHeader("Accept", "application/vnd.twitchtv.v5+json");
+    request.setRawHeader("Client-ID", constants::TWITCHD_CLIENT_ID);
+    request.setRawHeader("Authorization", QString("OAuth %1").arg(token).toLocal8Bit());
+
+    return get("current_user", request)
+        .then(offloaded_parser("current_user", &parse_user_data));
 }
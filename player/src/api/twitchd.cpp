@@ -1,4 +1,5 @@
 #include "api/twitchd.hpp"
+#include "api/token_manager.hpp"
 
 #include "constants.hpp"
 
@@ -49,7 +50,7 @@ static StreamIndex parse_stream_index_data(const QByteArray &raw) {
     return StreamIndex { playlist_infos };
 }
 
-static SegmentMetadata parse_metadata(const QByteArray &raw) {
+SegmentMetadata TwitchdAPI::parse_metadata(const QByteArray &raw) {
     auto json_data = QJsonDocument::fromJson(raw).object();
 
     return SegmentMetadata {
@@ -60,9 +61,18 @@ static SegmentMetadata parse_metadata(const QByteArray &raw) {
         json_data["stream_offset"].toDouble(),
         static_cast<quint64>(json_data["transc_r"].toDouble()),
         static_cast<quint64>(json_data["transc_r"].toDouble()),
+        json_data["sink_offset"].toDouble(),
     };
 }
 
+// The daemon forwards the token to Twitch: it has to be refreshed ahead of
+// its expiry like for any other authenticated call. A refresh that failed
+// still leaves the current one (if any) to try with
+static QtPromise::QPromise<QString> daemon_token() {
+    return TokenManager::instance().valid_token()
+        .fail([] { return TokenManager::instance().access_token(); });
+}
+
 static QUrl endpoint(const QString &path) {
     using namespace constants::settings::daemon;
 
@@ -86,45 +96,33 @@ static QUrl endpoint(const QString &path) {
 }
 
 TwitchdAPI::stream_index_response_t TwitchdAPI::stream_index(QString channel) {
-    using namespace constants::settings::oauth;
-
-    auto url = endpoint("stream_index");
-
-    QSettings settings;
-    auto oauth = settings.value(ACCESS_TOKEN_KEY).toString();
-
-    QUrlQuery url_query;
-    url_query.addQueryItem("channel", channel);
-    if (!oauth.isEmpty())
-        url_query.addQueryItem("oauth", oauth);
-    url.setQuery(url_query);
-
-    QNetworkRequest request { url };
-
-    return get(request).then(&parse_stream_index_data);
-}
-
-TwitchdAPI::metadata_response_t TwitchdAPI::metadata(QString channel, QString quality, QString key) {
-    auto url = endpoint("meta");
-
-    QUrlQuery url_query;
-    url_query.addQueryItem("channel", channel);
-    if (!quality.isEmpty())
-        url_query.addQueryItem("quality", quality);
-    url_query.addQueryItem("key", key);
-    url.setQuery(url_query);
-
-    QNetworkRequest request { url };
-
-    return get(request).then(&parse_metadata);
+    return daemon_token().then([=](QString oauth) {
+        auto url = endpoint("stream_index");
+
+        QUrlQuery url_query;
+        url_query.addQueryItem("channel", channel);
+        if (!oauth.isEmpty())
+            url_query.addQueryItem("oauth", oauth);
+        url.setQuery(url_query);
+
+        QNetworkRequest request { url };
+        request.setAttribute(PRIORITY_ATTRIBUTE, static_cast<int>(Priority::Interactive));
+        request.setAttribute(HEDGE_ATTRIBUTE, true);
+
+        return get("stream_index", request)
+            .then(offloaded_parser("stream_index", &parse_stream_index_data));
+    });
 }
 
 TwitchdAPI::daemon_version_response_t TwitchdAPI::daemon_version() {
     auto url = endpoint("version");
 
     QNetworkRequest request { url };
+    request.setAttribute(PRIORITY_ATTRIBUTE, static_cast<int>(Priority::Interactive));
+    // Used to probe whether the daemon is up, even right after it failed
+    request.setAttribute(BYPASS_BREAKER_ATTRIBUTE, true);
 
-    return get(request)
+    return get("daemon_version", request)
         .then([](const QByteArray &raw) {
             return QString(raw);
         });
@@ -135,25 +133,41 @@ TwitchdAPI::daemon_quit_response_t TwitchdAPI::daemon_quit() {
 
     QNetworkRequest request { url };
 
-    return post(request).then([](const QByteArray &) { });
+    return post("daemon_quit", request).then([](const QByteArray &) { });
 }
 
-QString TwitchdAPI::playback_url(QString channel, QString quality, QString meta_key) {
-    using namespace constants::settings::oauth;
+QUrl TwitchdAPI::base_url() {
+    return endpoint("");
+}
 
-    auto url = endpoint("play");
+TwitchdAPI::playback_url_response_t TwitchdAPI::playback_url(QString channel, QString quality,
+                                                             QString meta_key)
+{
+    return daemon_token().then([=](QString oauth) {
+        auto url = endpoint("play");
+
+        QUrlQuery url_query;
+        url_query.addQueryItem("channel", channel);
+        if (!quality.isEmpty())
+            url_query.addQueryItem("quality", quality);
+        if (!oauth.isEmpty())
+            url_query.addQueryItem("oauth", oauth);
+        url_query.addQueryItem("meta_key", meta_key);
+        url.setQuery(url_query);
+
+        return url.toString(QUrl::FullyEncoded);
+    });
+}
 
-    QSettings settings;
-    auto oauth = settings.value(ACCESS_TOKEN_KEY).toString();
+QUrl TwitchdAPI::metadata_stream_url(QString channel, QString quality, QString meta_key) {
+    auto url = endpoint("meta_stream");
 
     QUrlQuery url_query;
     url_query.addQueryItem("channel", channel);
     if (!quality.isEmpty())
         url_query.addQueryItem("quality", quality);
-    if (!oauth.isEmpty())
-        url_query.addQueryItem("oauth", oauth);
-    url_query.addQueryItem("meta_key", meta_key);
+    url_query.addQueryItem("key", meta_key);
     url.setQuery(url_query);
 
-    return url.toString(QUrl::FullyEncoded);
+    return url;
 }
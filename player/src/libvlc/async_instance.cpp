@@ -0,0 +1,15 @@
+#include "libvlc/async_instance.hpp"
+
+#include <QtConcurrent>
+
+namespace libvlc {
+
+AsyncInstance create_instance_async(std::vector<std::string> args) {
+    return QtPromise::qPromise(QtConcurrent::run([args] {
+        auto instance = std::make_shared<Instance>(args);
+
+        return instance->init_success() ? instance : nullptr;
+    }));
+}
+
+}
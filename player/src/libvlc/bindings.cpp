@@ -109,6 +109,32 @@ void MediaPlayer::set_position(float rate) {
     libvlc_media_player_set_position(&*this, rate);
 }
 
+std::optional<MediaStats> MediaPlayer::media_stats() {
+    auto media = libvlc_media_player_get_media(&*this);
+    if (!media)
+        return std::nullopt;
+
+    libvlc_media_stats_t stats;
+    auto success = libvlc_media_get_stats(media, &stats);
+    libvlc_media_release(media);
+
+    if (!success)
+        return std::nullopt;
+
+    return MediaStats {
+        stats.i_decoded_video,
+        stats.i_displayed_pictures,
+        stats.i_lost_pictures,
+        stats.i_decoded_audio,
+        stats.i_played_abuffers,
+        stats.i_lost_abuffers,
+    };
+}
+
+bool MediaPlayer::take_snapshot(const std::string &path, unsigned width, unsigned height) {
+    return libvlc_video_take_snapshot(&*this, 0, path.c_str(), width, height) == 0;
+}
+
 bool MediaPlayer::video_filters_enabled() {
     return _adjust_enabled;
 }
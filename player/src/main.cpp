@@ -1,22 +1,28 @@
 #include "constants.hpp"
 
-#include "libvlc/bindings.hpp"
+#include "libvlc/async_instance.hpp"
 
 #include "process/daemon_control.hpp"
 
 #include "ui/main_window.hpp"
 #include "ui/tray.hpp"
 #include "ui/widgets/stream_pane.hpp"
+#include "ui/utils/reconnect_scheduler.hpp"
 
+#include "api/metrics.hpp"
+#include "api/network.hpp"
 #include "api/pubsub.hpp"
+#include "api/stream_directory.hpp"
+#include "api/twitchd.hpp"
 
 #include <QApplication>
 #include <QSettings>
 #include <QMessageBox>
+#include <QElapsedTimer>
 
 #include <optional>
 
-constexpr auto EXPECTED_DAEMON_VERSION = "1.4.8";
+constexpr auto EXPECTED_DAEMON_VERSION = "1.6.0";
 
 struct Options {
     std::optional<QString> initial_channel;
@@ -27,10 +33,14 @@ using VLCArgs = std::vector<std::string>;
 static Options parse_options(QStringList args);
 static VLCArgs load_vlc_args();
 static void handle_vlc_init_failure();
-static bool init_daemon();
+static QtPromise::QPromise<bool> init_daemon();
 
 int main(int argc, char *argv[]) {
     using namespace constants::settings::ui;
+    using namespace constants::settings::network;
+
+    QElapsedTimer startup_timer;
+    startup_timer.start();
 
     QApplication app { argc, argv };
 
@@ -44,20 +54,60 @@ int main(int argc, char *argv[]) {
         .toBool();
     app.setQuitOnLastWindowClosed(!always_minimize_to_tray);
 
-    libvlc::Instance video_context { load_vlc_args() };
+    auto warm_up = settings
+        .value(KEY_WARM_UP_CONNECTIONS, DEFAULT_WARM_UP_CONNECTIONS)
+        .toBool();
 
-    if (!video_context.init_success()) {
-        handle_vlc_init_failure();
-        return EXIT_FAILURE;
+    // The connections get established while libvlc and the UI initialize
+    if (warm_up) {
+        NetworkService::instance().warm_up({
+            QUrl { "https://api.twitch.tv" },
+            QUrl { "https://id.twitch.tv" },
+            QUrl { "https://static-cdn.jtvnw.net" },
+        });
     }
 
-    if (!init_daemon()) {
-        return EXIT_FAILURE;
-    }
+    // Probing, upgrading and starting the daemon overlap with libvlc and the
+    // UI initialization, panes wait for it before playing
+    init_daemon()
+        .then([=, &startup_timer](bool ready) {
+            if (!ready) {
+                qApp->exit(EXIT_FAILURE);
+                return;
+            }
+
+            ApiMetrics::instance().record_daemon_ready(startup_timer.elapsed());
+
+            if (warm_up)
+                NetworkService::instance().warm_up({ TwitchdAPI::base_url() });
+
+            daemon_control::mark_ready();
+        });
+
+    // Panes show their pickers until libvlc is ready
+    auto video_context = libvlc::create_instance_async(load_vlc_args());
+
+    video_context
+        .then([&startup_timer](std::shared_ptr<libvlc::Instance> instance) {
+            if (!instance) {
+                handle_vlc_init_failure();
+                qApp->exit(EXIT_FAILURE);
+                return;
+            }
+
+            ApiMetrics::instance().record_vlc_ready(startup_timer.elapsed());
+        });
 
     TwitchPubSub pubsub;
+    StreamDirectory directory { pubsub };
+
+    auto first_page = std::make_shared<QMetaObject::Connection>();
+    *first_page = QObject::connect(&directory, &StreamDirectory::page_ready, [=, &startup_timer] {
+        ApiMetrics::instance().record_startup(startup_timer.elapsed(), warm_up);
+        QObject::disconnect(*first_page);
+    });
 
-    MainWindow main_window { video_context, pubsub };
+    MainWindow main_window { video_context, pubsub, directory };
     SystemTray tray { pubsub };
 
     auto pane = main_window.add_stream_pane(Position { 0, 0 });
@@ -66,6 +116,11 @@ int main(int argc, char *argv[]) {
     if (options.initial_channel)
         pane->play(*options.initial_channel);
 
+    // A pane waiting for its channel to come back can retry right away
+    QObject::connect(&pubsub, &TwitchPubSub::channel_went_live, [](auto channel) {
+        ReconnectScheduler::instance().recovered(channel);
+    });
+
     QObject::connect(&tray, &SystemTray::channel_open_requested, [&](auto channel) {
         auto pane = main_window.add_stream_pane(Position { 0, 0 });
         pane->play(channel);
@@ -135,11 +190,8 @@ static void handle_vlc_init_failure() {
     QMessageBox::critical(nullptr, "libvlc error", error_message);
 }
 
-static bool init_daemon() {
-    auto status = daemon_control::status();
-
-    if (!status.managed)
-        return true;
+static QtPromise::QPromise<bool> init_daemon() {
+    using daemon_control::Status;
 
     auto start_daemon = [] {
         if (!daemon_control::start()) {
@@ -148,32 +200,45 @@ static bool init_daemon() {
                 "Make sure that you have the correct permissions to run it"
             );
             QMessageBox::critical(nullptr, "Daemon error", error_message);
-            return false;
+            return QtPromise::QPromise<bool>::resolve(false);
         }
-        else {
-            return true;
-        }
-    };
 
-    if (!status.running) {
-        if (!start_daemon())
-            return false;
-    }
-    else if (status.version != EXPECTED_DAEMON_VERSION) {
-        if (!daemon_control::stop()) {
-            auto warning_message = QString(
-                "Failed to gracefully stop the daemon process\n"
-                "Your daemon is out of date and might lack a shutdown capability\n"
-                "Please try to manually stop the process called \"twitchd\" and run the app again\n"
-                "If you choose to ignore that warning, your experience might not be optimal"
-            );
-            QMessageBox::warning(nullptr, "Daemon warning", warning_message);
-            return true;
-        }
-
-        if (!start_daemon())
-            return false;
-    }
+        return daemon_control::wait_ready(EXPECTED_DAEMON_VERSION)
+            .then([](Status status) {
+                if (!status.running) {
+                    auto error_message = QString(
+                        "The daemon process was started but never answered\n"
+                        "Make sure that nothing else is listening on its port"
+                    );
+                    QMessageBox::critical(nullptr, "Daemon error", error_message);
+                }
+
+                return status.running;
+            });
+    };
 
-    return true;
+    return daemon_control::status()
+        .then([=](Status status) {
+            if (!status.managed || (status.running && status.version == EXPECTED_DAEMON_VERSION))
+                return QtPromise::QPromise<bool>::resolve(true);
+
+            if (!status.running)
+                return start_daemon();
+
+            return daemon_control::stop()
+                .then([=](bool stopped) {
+                    if (!stopped) {
+                        auto warning_message = QString(
+                            "Failed to gracefully stop the daemon process\n"
+                            "Your daemon is out of date and might lack a shutdown capability\n"
+                            "Please try to manually stop the process called \"twitchd\" and run the app again\n"
+                            "If you choose to ignore that warning, your experience might not be optimal"
+                        );
+                        QMessageBox::warning(nullptr, "Daemon warning", warning_message);
+                        return QtPromise::QPromise<bool>::resolve(true);
+                    }
+
+                    return start_daemon();
+                });
+        });
 }
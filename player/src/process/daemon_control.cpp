@@ -6,6 +6,14 @@
 
 #include <QProcess>
 #include <QSettings>
+#include <QElapsedTimer>
+
+#include <optional>
+
+constexpr auto READY_POLL_INTERVAL_MS = 100;
+constexpr auto READY_PROBE_TIMEOUT_MS = 500;
+
+static std::optional<QtPromise::QPromiseResolve<void>> resolve_ready;
 
 struct DaemonSettings {
     QString host;
@@ -60,22 +68,16 @@ bool start() {
     return QProcess::startDetached(constants::TWITCHD_PATH, arguments);
 }
 
-bool stop() {
-    bool stopped = false;
-
+QtPromise::QPromise<bool> stop() {
     TwitchdAPI api;
 
-    auto quit_response = api.daemon_quit()
-        .tap([&] {
-            stopped = true;
-        });
-
-    quit_response.timeout(2000).wait();
-
-    return stopped;
+    return api.daemon_quit()
+        .timeout(2000)
+        .then([] { return true; })
+        .fail([] { return false; });
 }
 
-Status status() {
+QtPromise::QPromise<Status> status(int timeout_ms) {
     using namespace constants::settings::daemon;
     QSettings settings;
 
@@ -84,15 +86,50 @@ Status status() {
 
     status.managed = settings.value(KEY_MANAGED, DEFAULT_MANAGED).toBool();
 
-    auto version_response = api.daemon_version()
-        .tap([&](QString version) {
+    return api.daemon_version()
+        .timeout(timeout_ms)
+        .then([=](QString version) mutable {
             status.running = true;
             status.version = version;
+            return status;
+        })
+        .fail([=] {
+            return status;
+        });
+}
+
+static QtPromise::QPromise<Status> poll_ready(const QString &version, QElapsedTimer since, int timeout_ms) {
+    return status(READY_PROBE_TIMEOUT_MS)
+        .then([=](Status status) {
+            auto ready = status.running && (version.isEmpty() || status.version == version);
+
+            if (ready || since.hasExpired(timeout_ms))
+                return QtPromise::QPromise<Status>::resolve(status);
+
+            return QtPromise::QPromise<void>::resolve()
+                .delay(READY_POLL_INTERVAL_MS)
+                .then([=] { return poll_ready(version, since, timeout_ms); });
         });
+}
+
+QtPromise::QPromise<Status> wait_ready(const QString &version, int timeout_ms) {
+    QElapsedTimer since;
+    since.start();
 
-    version_response.timeout(2000).wait();
+    return poll_ready(version, since, timeout_ms);
+}
+
+QtPromise::QPromise<void> ready() {
+    static auto promise = QtPromise::QPromise<void>([](const auto &resolve, auto) {
+        resolve_ready = resolve;
+    });
+
+    return promise;
+}
 
-    return status;
+void mark_ready() {
+    ready();
+    (*resolve_ready)();
 }
 
 }
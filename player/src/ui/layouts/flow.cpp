@@ -19,6 +19,12 @@ void FlowLayout::addItem(QLayoutItem *item) {
     itemList.append(item);
 }
 
+void FlowLayout::insertWidget(int index, QWidget *widget) {
+    addChildWidget(widget);
+    itemList.insert(qBound(0, index, itemList.size()), new QWidgetItem(widget));
+    invalidate();
+}
+
 int FlowLayout::horizontalSpacing() const {
     return smartSpacing(QStyle::PM_LayoutHorizontalSpacing);
 }
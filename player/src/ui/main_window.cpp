@@ -8,6 +8,7 @@
 #include "ui/widgets/foreign_widget.hpp"
 #include "ui/overlays/video_controls.hpp"
 #include "ui/tools/vlc_log_viewer.hpp"
+#include "ui/tools/api_diagnostics.hpp"
 
 #include "prelude/timer.hpp"
 #include "prelude/variant.hpp"
@@ -24,12 +25,14 @@ static void focus_pane(QWidget *pane) {
     pane->repaint();
 }
 
-MainWindow::MainWindow(libvlc::Instance &video_context, TwitchPubSub &pubsub, QWidget *parent):
+MainWindow::MainWindow(libvlc::AsyncInstance video_context, TwitchPubSub &pubsub,
+                       StreamDirectory &directory, QWidget *parent):
     QMainWindow(parent),
     _ui(std::make_unique<Ui::MainWindow>()),
     _video_context(video_context),
     _pubsub(pubsub),
-    _vlc_log_viewer(std::make_unique<VLCLogViewer>(video_context)),
+    _directory(directory),
+    _api_diagnostics(std::make_unique<ApiDiagnostics>()),
     _grid(new SplitterGrid(this)),
     _central_widget(new QStackedWidget(this))
 {
@@ -40,6 +43,12 @@ MainWindow::MainWindow(libvlc::Instance &video_context, TwitchPubSub &pubsub, QW
 
     setup_shortcuts();
 
+    // Ready before any pane gets to play, nothing gets logged before that
+    _video_context.then([this](std::shared_ptr<libvlc::Instance> instance) {
+        if (instance)
+            _vlc_log_viewer = std::make_unique<VLCLogViewer>(*instance);
+    });
+
     using namespace constants::settings::ui;
 
     QSettings settings;
@@ -71,7 +80,7 @@ void MainWindow::closeEvent(QCloseEvent *event) {
 }
 
 StreamPane * MainWindow::add_stream_pane(Position pos) {
-    auto pane = new StreamPane(_video_context, this);
+    auto pane = new StreamPane(_video_context, _directory, this);
 
     QObject::connect(
         pane,
@@ -169,7 +178,10 @@ void MainWindow::set_fullscreen(bool on) {
     _action_fullscreen->setChecked(on);
     for (auto pane: _panes) {
         match(pane,
-            [=](StreamPane *pane) { pane->stream()->video()->controls().set_fullscreen(on); },
+            [=](StreamPane *pane) {
+                if (auto stream = pane->stream())
+                    stream->video()->controls().set_fullscreen(on);
+            },
             [](auto) { }
         );
     }
@@ -194,8 +206,10 @@ void MainWindow::zoom(StreamPane *pane) {
     for (auto pane: _panes) {
         match(pane,
             [=](StreamPane *pane) {
-                pane->stream()->video()->controls().set_zoomed(true);
-                pane->stream()->video()->hint_layout_change();
+                if (auto stream = pane->stream()) {
+                    stream->video()->controls().set_zoomed(true);
+                    stream->video()->hint_layout_change();
+                }
             },
             [](auto) { }
         );
@@ -217,14 +231,20 @@ void MainWindow::unzoom() {
     // Windows workaround for weird display issues
     if (auto active_pane = focused_pane(); active_pane)
         match(*active_pane,
-            [](StreamPane *pane) { pane->stream()->chat()->redraw(); },
+            [](StreamPane *pane) {
+                if (auto stream = pane->stream())
+                    stream->chat()->redraw();
+            },
             [](auto) { }
         );
 
     _action_stream_zoom->setChecked(false);
     for (auto pane: _panes) {
         match(pane,
-            [](StreamPane *pane) { pane->stream()->video()->controls().set_zoomed(false); },
+            [](StreamPane *pane) {
+                if (auto stream = pane->stream())
+                    stream->video()->controls().set_zoomed(false);
+            },
             [](auto) { }
         );
     }
@@ -239,6 +259,8 @@ void MainWindow::setup_audio_devices() {
     match(*active_pane,
         [this](StreamPane *pane) {
             _audio_devices_menu->clear();
+            if (!pane->stream())
+                return;
             auto & mp = pane->stream()->video()->media_player();
             auto current_device_id = mp.get_current_device_id();
             for (auto device: mp.audio_devices()) {
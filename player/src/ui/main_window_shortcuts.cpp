@@ -9,13 +9,14 @@
 #include "ui/widgets/video_widget.hpp"
 
 #include "ui/tools/about_dialog.hpp"
+#include "ui/tools/api_diagnostics.hpp"
 #include "ui/tools/options_dialog.hpp"
 #include "ui/tools/video_filters.hpp"
 #include "ui/tools/vlc_log_viewer.hpp"
 
 #include "constants.hpp"
 
-#include "api/oauth.hpp"
+#include "api/token_manager.hpp"
 
 #include "prelude/variant.hpp"
 
@@ -100,7 +101,10 @@ void MainWindow::setup_shortcuts() {
     auto with_active_stream = [=](auto action) {
         if (auto active_pane = focused_pane(); active_pane) {
             match(*active_pane,
-                [=](StreamPane *pane) { action(pane->stream()); },
+                [=](StreamPane *pane) {
+                    if (auto stream = pane->stream())
+                        action(stream);
+                },
                 [](auto) { }
             );
         }
@@ -224,6 +228,8 @@ void MainWindow::setup_shortcuts() {
         if (auto active_pane = focused_pane(); active_pane) {
             match(*active_pane,
                 [this](StreamPane *pane) {
+                    if (!pane->stream())
+                        return;
                     auto & mp = pane->stream()->video()->media_player();
                     auto tool = new VideoFilters(mp, this);
                     tool->show();
@@ -234,19 +240,17 @@ void MainWindow::setup_shortcuts() {
     });
     // Tools
     add_action(_ui->actionLogs, [this] {
+        if (!_vlc_log_viewer)
+            return;
         _vlc_log_viewer->show();
         _vlc_log_viewer->raise();
     });
+    add_action(_ui->actionApiDiagnostics, [this] {
+        _api_diagnostics->show();
+        _api_diagnostics->raise();
+    });
     add_action(_ui->actionLoginWithTwitch, [] {
-        {
-            QSettings settings;
-
-            settings.remove(constants::settings::oauth::ACCESS_TOKEN_KEY);
-            settings.remove(constants::settings::oauth::REFRESH_TOKEN_KEY);
-        }
-
-        auto oauth = std::make_shared<OAuth>();
-        oauth->query_token().then([_retain = std::move(oauth)](QString) { });
+        TokenManager::instance().login();
     });
     // Preferences
     add_action(_ui->actionOptions, [this] {
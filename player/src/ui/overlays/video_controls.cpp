@@ -96,6 +96,10 @@ void VideoControls::set_delay(float delay) {
     _ui->delayLabel->setText(formatted_delay);
 }
 
+void VideoControls::set_delay_summary(const QString &summary) {
+    _ui->delayLabel->setToolTip(summary);
+}
+
 void VideoControls::set_volume_icon() {
     auto icon_path = _muted ? ":/icons/volume_off.png" : ":/icons/volume_on.png";
     _ui->volumeLabel->setPixmap(QPixmap(icon_path));
@@ -1,14 +1,22 @@
 #include "ui/overlays/video_details.hpp"
 #include "ui_stream_details.h"
 
+#include "api/images.hpp"
+#include "api/stream_prewarmer.hpp"
+
 #include "prelude/timer.hpp"
 
 #include <QTimer>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QPointer>
 
 #include <QPushButton>
 
+// Pushes normally come every 30 seconds
+constexpr auto DETAILS_POLL_INTERVAL_MS = 60 * 1000;
+constexpr auto VIEWCOUNT_PUSH_STALE_MS = 2 * 60 * 1000;
+
 #include "ui/native/capabilities.hpp"
 
 VideoDetails::VideoDetails(QWidget *parent):
@@ -18,8 +26,7 @@ VideoDetails::VideoDetails(QWidget *parent):
     _spinner_timer(new QTimer(this)),
     _stream_details_widget(std::make_unique<QWidget>()),
     _stream_details_ui(std::make_unique<Ui::StreamDetails>()),
-    _stream_details_timer(new QTimer(this)),
-    _http_client(new QNetworkAccessManager(this))
+    _stream_details_timer(new QTimer(this))
 {
     setWindowFlags(Qt::Window | Qt::FramelessWindowHint);
 
@@ -50,9 +57,13 @@ VideoDetails::VideoDetails(QWidget *parent):
 
     _stream_details_ui->setupUi(_stream_details_widget.get());
 
-    interval(this, 60 * 1000, [=] { fetch_channel_details(); });
+    interval(this, DETAILS_POLL_INTERVAL_MS, [=] {
+        auto pushed = _last_viewcount_push.isValid()
+            && !_last_viewcount_push.hasExpired(VIEWCOUNT_PUSH_STALE_MS);
 
-    _http_client->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
+        if (!pushed || !_has_valid_stream_details)
+            fetch_channel_details();
+    });
 
     set_transparent(to_native_handle(winId()));
 }
@@ -152,7 +163,34 @@ void VideoDetails::set_channel(const QString &channel) {
     _channel = channel;
     _stream_details_ui->channelLogo->setPixmap(QPixmap{});
     _has_valid_stream_details = false;
-    fetch_channel_details();
+    _last_viewcount_push.invalidate();
+
+    // Polling picks up from there
+    if (auto stream = StreamPrewarmer::instance().stream(channel))
+        fill_stream_details(*stream);
+    else
+        fetch_channel_details();
+}
+
+void VideoDetails::set_viewcount(int viewers) {
+    _last_viewcount_push.start();
+
+    _stream_details_ui->labelViewcount->setText(QString::number(viewers));
+    update_uptime();
+
+    if (_show_stream_details)
+        repaint();
+}
+
+void VideoDetails::update_uptime() {
+    if (!_created_at.isValid())
+        return;
+
+    auto uptime_secs = _created_at.secsTo(QDateTime::currentDateTime());
+    auto uptime_hours = uptime_secs / 3600;
+    auto uptime_minutes = (uptime_secs - uptime_hours * 3600) / 60;
+
+    _stream_details_ui->labelUptime->setText(QString("%1:%2").arg(uptime_hours).arg(uptime_minutes, 2, 10, QChar('0')));
 }
 
 void VideoDetails::hide_stream_details() {
@@ -160,23 +198,25 @@ void VideoDetails::hide_stream_details() {
     repaint();
 }
 
-void VideoDetails::fetch_channel_details() {
-    auto fill_stream_info = [=](StreamData data) {
-        if (_stream_details_ui->channelLogo->pixmap()->isNull())
-            fetch_channel_logo(data.channel.logo_url);
+void VideoDetails::fill_stream_details(const StreamData &data) {
+    if (_stream_details_ui->channelLogo->pixmap()->isNull())
+        fetch_channel_logo(data.channel.logo_url);
 
-        auto uptime_secs = data.created_at.secsTo(QDateTime::currentDateTime());
-        auto uptime_hours = uptime_secs / 3600;
-        auto uptime_minutes = (uptime_secs - uptime_hours * 3600) / 60;
+    _created_at = data.created_at;
 
-        _stream_details_ui->labelChannel->setText(_channel.toUpper());
-        _stream_details_ui->labelTitle->setText(data.channel.title);
-        _stream_details_ui->labelPlaying->setText(data.current_game);
-        _stream_details_ui->labelViewcount->setText(QString::number(data.viewcount));
-        _stream_details_ui->labelUptime->setText(QString("%1:%2").arg(uptime_hours).arg(uptime_minutes, 2, 10, QChar('0')));
+    _stream_details_ui->labelChannel->setText(_channel.toUpper());
+    _stream_details_ui->labelTitle->setText(data.channel.title);
+    _stream_details_ui->labelPlaying->setText(data.current_game);
+    _stream_details_ui->labelViewcount->setText(QString::number(data.viewcount));
+    update_uptime();
 
-        _has_valid_stream_details = true;
-        repaint();
+    _has_valid_stream_details = true;
+    repaint();
+}
+
+void VideoDetails::fetch_channel_details() {
+    auto fill_stream_info = [=](StreamData data) {
+        fill_stream_details(data);
     };
 
     auto fetch_stream = [=](QList<ChannelData> channels) {
@@ -196,13 +236,16 @@ void VideoDetails::fetch_channel_details() {
 }
 
 void VideoDetails::fetch_channel_logo(const QString &url) {
-    auto request = QNetworkRequest(QUrl(url));
-    auto preview_reply = _http_client->get(request);
-
-    QObject::connect(preview_reply, &QNetworkReply::finished, [=] {
-        auto data = preview_reply->readAll();
-        auto pixmap = QPixmap::fromImage(QImage::fromData(data));
-        _stream_details_ui->channelLogo->setPixmap(pixmap);
-        preview_reply->deleteLater();
-    });
+    QPointer<QLabel> logo = _stream_details_ui->channelLogo;
+    auto & images = ImageService::instance();
+
+    if (auto cached = images.cached(url, logo->maximumSize()))
+        logo->setPixmap(*cached);
+
+    images
+        .fetch(url, logo->maximumSize())
+        .then([=](QPixmap pixmap) {
+            if (logo)
+                logo->setPixmap(pixmap);
+        });
 }
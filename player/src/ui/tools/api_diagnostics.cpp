@@ -0,0 +1,307 @@
+#include "ui/tools/api_diagnostics.hpp"
+#include "ui_api_diagnostics.h"
+
+#include "api/metrics.hpp"
+#include "api/network.hpp"
+
+#include "prelude/timer.hpp"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMessageBox>
+
+constexpr auto REFRESH_DELAY_MS = 500;
+
+static const QStringList ENDPOINT_COLUMNS = {
+    "Endpoint", "Calls", "Errors",
+    "Queue p50", "Queue p95", "Connect p50", "TTFB p50", "TTFB p95",
+    "Total p50", "Total p95", "Total max",
+    "Parse p50 (us)", "Parse p95 (us)",
+    "Hedges", "Hedges won", "Bytes",
+};
+
+static const QStringList HOST_COLUMNS = {
+    "Host", "Requests", "Connections opened", "Reused",
+    "HTTP/2", "In flight", "Queued", "Warmed up", "Breaker",
+};
+
+static const QStringList PLAYBACK_COLUMNS = {
+    "Time", "Channel", "Event",
+};
+
+static auto milliseconds(const Histogram &histogram, double p) {
+    if (histogram.count() == 0)
+        return QString("-");
+    return QString("%1 ms").arg(histogram.percentile(p));
+}
+
+static auto microseconds(const Histogram &histogram, double p) {
+    if (histogram.count() == 0)
+        return QString("-");
+    return QString("%1 us").arg(histogram.percentile(p));
+}
+
+static auto plain(const Histogram &histogram, double p) {
+    if (histogram.count() == 0)
+        return QString("-");
+    return QString::number(histogram.percentile(p));
+}
+
+static QString breaker_name(NetworkService::BreakerState state) {
+    switch (state) {
+        case NetworkService::BreakerState::Closed:   return "closed";
+        case NetworkService::BreakerState::Open:     return "open";
+        case NetworkService::BreakerState::HalfOpen: return "half-open";
+    }
+    return { };
+}
+
+static void fill_row(QTableWidget *table, int row, const QStringList &cells) {
+    for (int column = 0; column < cells.size(); ++column)
+        table->setItem(row, column, new QTableWidgetItem(cells[column]));
+}
+
+ApiDiagnostics::ApiDiagnostics(QWidget *parent):
+    QWidget(parent),
+    _ui(std::make_unique<Ui::ApiDiagnostics>())
+{
+    _ui->setupUi(this);
+
+    _ui->endpointsTable->setColumnCount(ENDPOINT_COLUMNS.size());
+    _ui->endpointsTable->setHorizontalHeaderLabels(ENDPOINT_COLUMNS);
+    _ui->endpointsTable->horizontalHeader()
+        ->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    _ui->hostsTable->setColumnCount(HOST_COLUMNS.size());
+    _ui->hostsTable->setHorizontalHeaderLabels(HOST_COLUMNS);
+    _ui->hostsTable->horizontalHeader()
+        ->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    _ui->playbackTable->setColumnCount(PLAYBACK_COLUMNS.size());
+    _ui->playbackTable->setHorizontalHeaderLabels(PLAYBACK_COLUMNS);
+    _ui->playbackTable->horizontalHeader()
+        ->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    // Metrics change on every single request: coalesce the redraws
+    _schedule_refresh = debounced(this, REFRESH_DELAY_MS, [this] { refresh(); });
+
+    QObject::connect(&ApiMetrics::instance(), &ApiMetrics::updated, this, [this] {
+        if (isVisible())
+            _schedule_refresh();
+    });
+
+    QObject::connect(&NetworkService::instance(), &NetworkService::breaker_changed, this, [this] {
+        if (isVisible())
+            _schedule_refresh();
+    });
+
+    QObject::connect(_ui->saveButton, &QPushButton::clicked, [this] {
+        save_snapshot();
+    });
+}
+
+ApiDiagnostics::~ApiDiagnostics() = default;
+
+void ApiDiagnostics::showEvent(QShowEvent *event) {
+    refresh();
+    QWidget::showEvent(event);
+}
+
+void ApiDiagnostics::refresh() {
+    refresh_endpoints();
+    refresh_hosts();
+    refresh_playback();
+
+    auto & startup = ApiMetrics::instance().startup();
+    QStringList startup_parts;
+    if (startup.time_to_first_picker_ms >= 0) {
+        startup_parts << QString("Time to first picker: %1 ms (%2)")
+            .arg(startup.time_to_first_picker_ms)
+            .arg(startup.warmed_up ? "warmed up" : "cold");
+    }
+    if (startup.time_to_daemon_ready_ms >= 0)
+        startup_parts << QString("daemon ready: %1 ms").arg(startup.time_to_daemon_ready_ms);
+    if (startup.time_to_vlc_ready_ms >= 0)
+        startup_parts << QString("libvlc ready: %1 ms").arg(startup.time_to_vlc_ready_ms);
+    _ui->startupLabel->setText(startup_parts.join(", "));
+
+    auto & pubsub = ApiMetrics::instance().pubsub();
+    _ui->pubsubLabel->setText(QString("PubSub reconnects: %1 (%2 PONG timeouts), resubscribed in %3 (p50) / %4 (p95)")
+        .arg(pubsub.reconnects)
+        .arg(pubsub.pong_timeouts)
+        .arg(milliseconds(pubsub.resubscribe, 50))
+        .arg(milliseconds(pubsub.resubscribe, 95)));
+
+    auto & gui_loop = ApiMetrics::instance().gui_loop();
+    _ui->guiLoopLabel->setText(QString("GUI event loop lag: %1 (p95) / %2 (max), channel search: %3 (p95) / %4 (max)")
+        .arg(milliseconds(gui_loop.lag, 95))
+        .arg(milliseconds(gui_loop.lag, 100))
+        .arg(microseconds(gui_loop.channel_search, 95))
+        .arg(microseconds(gui_loop.channel_search, 100)));
+}
+
+void ApiDiagnostics::refresh_endpoints() {
+    auto & endpoints = ApiMetrics::instance().endpoints();
+    auto table = _ui->endpointsTable;
+
+    table->setRowCount(endpoints.size());
+
+    int row = 0;
+    for (auto it = endpoints.begin(); it != endpoints.end(); ++it, ++row) {
+        auto & metrics = *it;
+
+        // Timings only cover completed responses, every call has an outcome
+        quint64 calls = 0, errors = 0;
+        for (auto outcome_it = metrics.outcomes.begin(); outcome_it != metrics.outcomes.end(); ++outcome_it) {
+            auto & outcome = outcome_it.key();
+            calls += outcome_it.value();
+            if (outcome != "ok" && outcome != "cancelled" && outcome != "superseded")
+                errors += outcome_it.value();
+        }
+
+        fill_row(table, row, {
+            it.key(),
+            QString::number(calls),
+            QString::number(errors),
+            milliseconds(metrics.queue, 50),
+            milliseconds(metrics.queue, 95),
+            milliseconds(metrics.connect, 50),
+            milliseconds(metrics.ttfb, 50),
+            milliseconds(metrics.ttfb, 95),
+            milliseconds(metrics.total, 50),
+            milliseconds(metrics.total, 95),
+            milliseconds(metrics.total, 100),
+            plain(metrics.parse, 50),
+            plain(metrics.parse, 95),
+            QString::number(metrics.hedges_sent),
+            QString::number(metrics.hedges_won),
+            QString::number(metrics.bytes),
+        });
+    }
+}
+
+void ApiDiagnostics::refresh_hosts() {
+    auto hosts = NetworkService::instance().stats();
+    auto table = _ui->hostsTable;
+
+    table->setRowCount(hosts.size());
+
+    int row = 0;
+    for (auto it = hosts.begin(); it != hosts.end(); ++it, ++row) {
+        auto & stats = *it;
+
+        fill_row(table, row, {
+            it.key(),
+            QString::number(stats.requests),
+            stats.encrypted ? QString::number(stats.connections_opened) : QString("-"),
+            stats.encrypted ? QString::number(std::max(0, stats.requests - stats.connections_opened)) : QString("-"),
+            QString::number(stats.http2_requests),
+            QString::number(stats.in_flight),
+            QString::number(stats.queued),
+            stats.warmed_up ? "yes" : "no",
+            stats.breaker == NetworkService::BreakerState::Open
+                ? QString("open (%1 s)").arg(NetworkService::instance().retry_in_ms(it.key()) / 1000)
+                : breaker_name(stats.breaker),
+        });
+    }
+}
+
+void ApiDiagnostics::refresh_playback() {
+    auto & events = ApiMetrics::instance().playback_events();
+    auto table = _ui->playbackTable;
+
+    table->setRowCount(events.size());
+
+    // Most recent first
+    int row = 0;
+    for (auto it = events.rbegin(); it != events.rend(); ++it, ++row) {
+        fill_row(table, row, {
+            it->at.toString(Qt::ISODate),
+            it->channel,
+            it->reason,
+        });
+    }
+}
+
+QJsonObject ApiDiagnostics::snapshot() {
+    QJsonObject hosts;
+
+    auto host_stats = NetworkService::instance().stats();
+    for (auto it = host_stats.begin(); it != host_stats.end(); ++it) {
+        hosts.insert(it.key(), QJsonObject {
+            { "requests",           it->requests },
+            { "encrypted",          it->encrypted },
+            { "connections_opened", it->connections_opened },
+            { "http2_requests",     it->http2_requests },
+            { "in_flight",          it->in_flight },
+            { "queued",             it->queued },
+            { "warmed_up",          it->warmed_up },
+            { "breaker",            breaker_name(it->breaker) },
+            { "consecutive_failures", it->consecutive_failures },
+        });
+    }
+
+    QJsonArray playback;
+    for (auto & event: ApiMetrics::instance().playback_events()) {
+        playback.append(QJsonObject {
+            { "at",      event.at.toString(Qt::ISODate) },
+            { "channel", event.channel },
+            { "reason",  event.reason },
+        });
+    }
+
+    auto & startup = ApiMetrics::instance().startup();
+    auto & pubsub = ApiMetrics::instance().pubsub();
+    auto & gui_loop = ApiMetrics::instance().gui_loop();
+
+    return QJsonObject {
+        { "taken_at",  QDateTime::currentDateTime().toString(Qt::ISODate) },
+        { "endpoints", ApiMetrics::instance().to_json() },
+        { "hosts",     hosts },
+        { "playback",  playback },
+        { "startup",   QJsonObject {
+            { "time_to_first_picker_ms", startup.time_to_first_picker_ms },
+            { "warmed_up",               startup.warmed_up },
+            { "time_to_daemon_ready_ms", startup.time_to_daemon_ready_ms },
+            { "time_to_vlc_ready_ms",    startup.time_to_vlc_ready_ms },
+        } },
+        { "pubsub",    QJsonObject {
+            { "reconnects",      static_cast<qint64>(pubsub.reconnects) },
+            { "pong_timeouts",   static_cast<qint64>(pubsub.pong_timeouts) },
+            { "resubscribe_p50", pubsub.resubscribe.percentile(50) },
+            { "resubscribe_p95", pubsub.resubscribe.percentile(95) },
+            { "resubscribe_max", pubsub.resubscribe.max() },
+        } },
+        { "gui_loop",  QJsonObject {
+            { "lag_p50_ms", gui_loop.lag.percentile(50) },
+            { "lag_p95_ms", gui_loop.lag.percentile(95) },
+            { "lag_max_ms", gui_loop.lag.max() },
+            { "channel_search_p95_us", gui_loop.channel_search.percentile(95) },
+            { "channel_search_max_us", gui_loop.channel_search.max() },
+        } },
+    };
+}
+
+void ApiDiagnostics::save_snapshot() {
+    auto default_name = QString("api-diagnostics-%1.json")
+        .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+
+    auto path = QFileDialog::getSaveFileName(
+        this, "Save API diagnostics", default_name, "JSON (*.json)"
+    );
+
+    if (path.isEmpty())
+        return;
+
+    QFile file { path };
+    if (!file.open(QIODevice::WriteOnly)) {
+        QMessageBox::warning(this, "API diagnostics", file.errorString());
+        return;
+    }
+
+    file.write(QJsonDocument(snapshot()).toJson(QJsonDocument::Indented));
+}
@@ -12,6 +12,7 @@
 #include <QFileDialog>
 #include <QKeySequenceEdit>
 #include <QSettings>
+#include <QPointer>
 
 constexpr auto LIST_WIDGET_ITEM_FLAGS = Qt::ItemIsEnabled
                                       | Qt::ItemIsEditable
@@ -52,13 +53,13 @@ OptionsDialog::OptionsDialog(TwitchPubSub &pubsub, QWidget *parent):
         _ui->daemonUnmanagedGroupbox->setChecked(!on);
         QSettings settings;
         settings.setValue(constants::settings::daemon::KEY_MANAGED, on);
-        update_daemon("Querying...", [] { });
+        update_daemon("Querying...", [] { return QtPromise::QPromise<void>::resolve(); });
     });
     QObject::connect(_ui->daemonUnmanagedGroupbox, &QGroupBox::toggled, [this](bool on) {
         _ui->daemonManagedGroupbox->setChecked(!on);
         QSettings settings;
         settings.setValue(constants::settings::daemon::KEY_MANAGED, !on);
-        update_daemon("Querying...", [] { });
+        update_daemon("Querying...", [] { return QtPromise::QPromise<void>::resolve(); });
     });
     QObject::connect(_ui->daemonIndexCacheTimeout, &QSlider::valueChanged, [this](int value) {
         _ui->daemonIndexCacheTimeoutLabel->setText(QString("%1 seconds").arg(value));
@@ -80,11 +81,16 @@ OptionsDialog::OptionsDialog(TwitchPubSub &pubsub, QWidget *parent):
     });
 
     QObject::connect(_ui->daemonStart, &QPushButton::clicked, [this] {
-        update_daemon("Starting...", [] { daemon_control::start(); });
+        update_daemon("Starting...", [] {
+            daemon_control::start();
+            return daemon_control::wait_ready().then([](daemon_control::Status) { });
+        });
     });
 
     QObject::connect(_ui->daemonStop, &QPushButton::clicked, [this] {
-        update_daemon("Stopping...", [] { daemon_control::stop(); });
+        update_daemon("Stopping...", [] {
+            return daemon_control::stop().then([](bool) { });
+        });
     });
 
     QObject::connect(_ui->pubsubChannelsListAdd, &QPushButton::clicked, [this] {
@@ -168,7 +174,7 @@ void OptionsDialog::load_settings() {
     }
     _ui->keybindsFrame->widget()->setLayout(keybinds_layout);
 
-    update_daemon("Querying...", [] { });
+    update_daemon("Querying...", [] { return QtPromise::QPromise<void>::resolve(); });
 
     _ui->daemonManagedHost->setText(settings.value(KEY_HOST_MANAGED, DEFAULT_HOST_MANAGED).toString());
     _ui->daemonManagedPort->setValue(settings.value(KEY_PORT_MANAGED, DEFAULT_PORT_MANAGED).value<quint16>());
@@ -259,16 +265,23 @@ void OptionsDialog::save_settings() {
             });
 }
 
-void OptionsDialog::update_daemon(QString message, std::function<void ()> action) {
-    using namespace constants::settings::daemon;
-
+void OptionsDialog::update_daemon(QString message, std::function<QtPromise::QPromise<void> ()> action) {
     _ui->daemonStart->setEnabled(false);
     _ui->daemonStop->setEnabled(false);
     _ui->daemonStatus->setText(message);
 
-    action();
+    QPointer<OptionsDialog> self = this;
 
-    auto daemon_status = daemon_control::status();
+    action()
+        .then([] { return daemon_control::status(); })
+        .then([=](daemon_control::Status daemon_status) {
+            if (self)
+                show_daemon_status(daemon_status);
+        });
+}
+
+void OptionsDialog::show_daemon_status(const daemon_control::Status &daemon_status) {
+    using namespace constants::settings::daemon;
 
     QSettings settings;
 
@@ -1,6 +1,7 @@
 #include "ui/tray.hpp"
 
 #include "api/pubsub.hpp"
+#include "api/stream_prewarmer.hpp"
 
 #include "prelude/timer.hpp"
 
@@ -13,8 +14,23 @@ SystemTray::SystemTray(TwitchPubSub &pubsub):
     _pubsub(pubsub)
 {
     QObject::connect(&pubsub, &TwitchPubSub::channel_went_live, [=](auto channel) {
+        using namespace constants::settings::notifications;
+
+        // Other channels are listened to as well (e.g. followed ones for the
+        // stream directory), only monitored ones deserve a notification
+        QSettings settings;
+        auto monitored = settings
+            .value(KEY_PUBSUB_CHANNELS, DEFAULT_PUBSUB_CHANNELS)
+            .toStringList();
+
+        if (!monitored.contains(channel, Qt::CaseInsensitive))
+            return;
+
         channel_to_play = channel;
 
+        // So that clicking the notification opens the stream right away
+        StreamPrewarmer::instance().prewarm(channel);
+
         auto alert_title = QString("%1 just went live!").arg(channel);
         auto alert_message = QString("Click to play");
 
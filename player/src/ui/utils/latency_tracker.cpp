@@ -0,0 +1,78 @@
+#include "ui/utils/latency_tracker.hpp"
+
+#include "api/metadata_stream.hpp"
+
+#include <QDateTime>
+
+// The website shows aditional delay
+// Noticed it to be around +1s
+constexpr auto WEBSITE_DELAY_OFFSET_MS = 1'000;
+constexpr auto MAX_PLAUSIBLE_DELAY_MS = 60'000;
+// Weight of a new sample in the exponential moving average
+constexpr auto SMOOTHING_FACTOR = 0.2;
+
+LatencyTracker::LatencyTracker(QObject *parent):
+    QObject(parent),
+    _metadata_stream(new MetadataStream(this))
+{
+    QObject::connect(_metadata_stream, &MetadataStream::metadata_received, [=](auto metadata) {
+        _metadata = metadata;
+    });
+}
+
+void LatencyTracker::track(QString channel, QString quality, QString meta_key) {
+    _metadata.reset();
+    _smoothed_ms.reset();
+    _histogram.reset();
+
+    _metadata_stream->open(channel, quality, meta_key);
+}
+
+void LatencyTracker::stop() {
+    _metadata_stream->close();
+}
+
+void LatencyTracker::sample(qint64 playback_time_ms) {
+    if (!_metadata)
+        return;
+
+    auto now = QDateTime::currentMSecsSinceEpoch();
+
+    // The last segment was transcoded at `transc_r` and starts `sink_offset`
+    // seconds into our stream: the frame being shown was transcoded
+    // `playback_time - sink_offset` later than that
+    auto segment_start_ms = static_cast<qint64>(_metadata->sink_offset * 1000);
+    auto transcoded_at = static_cast<qint64>(_metadata->transc_r)
+                       + playback_time_ms - segment_start_ms;
+
+    auto delay_ms = now - transcoded_at + WEBSITE_DELAY_OFFSET_MS;
+
+    if (delay_ms < 0 || delay_ms > MAX_PLAUSIBLE_DELAY_MS)
+        return;
+
+    _histogram.record(delay_ms);
+
+    _smoothed_ms = _smoothed_ms
+        ? *_smoothed_ms + SMOOTHING_FACTOR * (delay_ms - *_smoothed_ms)
+        : delay_ms;
+
+    emit latency_changed(*_smoothed_ms);
+}
+
+std::optional<double> LatencyTracker::latency() const {
+    return _smoothed_ms;
+}
+
+const Histogram & LatencyTracker::histogram() const {
+    return _histogram;
+}
+
+QString LatencyTracker::summary() const {
+    auto seconds = [](qint64 ms) { return QString::number(ms / 1000., 'f', 2); };
+
+    return QString("p50: %1s  p95: %2s  max: %3s (%4 samples)")
+        .arg(seconds(_histogram.percentile(50)))
+        .arg(seconds(_histogram.percentile(95)))
+        .arg(seconds(_histogram.max()))
+        .arg(_histogram.count());
+}
@@ -0,0 +1,137 @@
+#include "ui/utils/playback_monitor.hpp"
+
+#include "libvlc/bindings.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <QtConcurrent>
+
+constexpr auto SAMPLE_INTERVAL_MS = 1'000;
+constexpr auto SNAPSHOT_EVERY_TICKS = 2;
+constexpr auto SNAPSHOT_WIDTH = 64;
+
+constexpr auto FROZEN_AFTER_MS = 5'000;
+constexpr auto SILENT_AFTER_MS = 5'000;
+// Identical frames alone might just be a static scene, unless the audio
+// stalled as well
+constexpr auto STILL_FRAME_AFTER_MS = 20'000;
+
+PlaybackMonitor::PlaybackMonitor(libvlc::MediaPlayer &media_player, QObject *parent):
+    QObject(parent),
+    _media_player(media_player),
+    _sample_timer(new QTimer(this)),
+    _snapshot_watcher(new QFutureWatcher<std::optional<uint>>(this))
+{
+    auto temp_dir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    _snapshot_path = QDir(temp_dir).filePath(
+        QString("twitch-player-snapshot-%1.png").arg(reinterpret_cast<quintptr>(this), 0, 16)
+    );
+
+    _sample_timer->setInterval(SAMPLE_INTERVAL_MS);
+    QObject::connect(_sample_timer, &QTimer::timeout, [=] { sample(); });
+
+    QObject::connect(_snapshot_watcher, &QFutureWatcherBase::finished, [=] {
+        if (!_sample_timer->isActive())
+            return;
+
+        // A snapshot that could not be taken tells nothing about the frames
+        auto hash = _snapshot_watcher->result();
+        if (!hash)
+            return;
+
+        if (_frame_hash && *_frame_hash == *hash)
+            _frame_identical_for += SNAPSHOT_EVERY_TICKS * SAMPLE_INTERVAL_MS;
+        else
+            _frame_identical_for = 0;
+
+        _frame_hash = hash;
+    });
+}
+
+PlaybackMonitor::~PlaybackMonitor() {
+    _snapshot_watcher->waitForFinished();
+    QFile::remove(_snapshot_path);
+}
+
+void PlaybackMonitor::start() {
+    _ticks = 0;
+    _displayed_pictures.reset();
+    _played_audio_buffers.reset();
+    _audio_seen = false;
+    _frame_hash.reset();
+    _pictures_stalled_for = 0;
+    _audio_stalled_for = 0;
+    _frame_identical_for = 0;
+
+    _sample_timer->start();
+}
+
+void PlaybackMonitor::stop() {
+    _sample_timer->stop();
+}
+
+void PlaybackMonitor::sample() {
+    auto stats = _media_player.media_stats();
+    if (!stats)
+        return;
+
+    // Nothing to judge until the first pictures made it to the screen
+    if (stats->displayed_pictures == 0)
+        return;
+
+    auto pictures_progressed = _displayed_pictures && stats->displayed_pictures > *_displayed_pictures;
+    auto audio_progressed = _played_audio_buffers && stats->played_audio_buffers > *_played_audio_buffers;
+
+    if (_displayed_pictures)
+        _pictures_stalled_for = pictures_progressed ? 0 : _pictures_stalled_for + SAMPLE_INTERVAL_MS;
+
+    // Streams without audio (or before it starts) are not silent
+    _audio_seen = _audio_seen || stats->played_audio_buffers > 0;
+    if (_played_audio_buffers && _audio_seen)
+        _audio_stalled_for = audio_progressed ? 0 : _audio_stalled_for + SAMPLE_INTERVAL_MS;
+
+    _displayed_pictures = stats->displayed_pictures;
+    _played_audio_buffers = stats->played_audio_buffers;
+
+    if (_ticks++ % SNAPSHOT_EVERY_TICKS == 0)
+        sample_frame();
+
+    auto audio_stalled = _audio_seen && _audio_stalled_for >= SILENT_AFTER_MS;
+
+    if (_pictures_stalled_for >= FROZEN_AFTER_MS)
+        report("Frozen picture (no frame displayed)");
+    else if (_frame_identical_for >= FROZEN_AFTER_MS && (audio_stalled || !_audio_seen))
+        report("Frozen picture (identical frames)");
+    else if (_frame_identical_for >= STILL_FRAME_AFTER_MS)
+        report("Frozen picture (identical frames)");
+    else if (audio_stalled && pictures_progressed)
+        report("Silent audio (no buffer played)");
+}
+
+// Snapshots block until the next frame is rendered, and the file has to be
+// read back: both happen on a worker thread
+void PlaybackMonitor::sample_frame() {
+    if (_snapshot_watcher->isRunning())
+        return;
+
+    auto take_hash = [&media_player = _media_player, path = _snapshot_path]() -> std::optional<uint> {
+        if (!media_player.take_snapshot(path.toStdString(), SNAPSHOT_WIDTH, 0))
+            return std::nullopt;
+
+        QFile snapshot { path };
+        if (!snapshot.open(QIODevice::ReadOnly))
+            return std::nullopt;
+
+        return qHash(snapshot.readAll());
+    };
+
+    _snapshot_watcher->setFuture(QtConcurrent::run(take_hash));
+}
+
+void PlaybackMonitor::report(const QString &reason) {
+    stop();
+    emit stalled(reason);
+}
@@ -0,0 +1,131 @@
+#include "ui/utils/reconnect_scheduler.hpp"
+
+#include "api/network.hpp"
+#include "api/twitchd.hpp"
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QTimer>
+
+#include <algorithm>
+#include <limits>
+
+constexpr auto INITIAL_BACKOFF_MS = 1'000;
+constexpr auto MAX_BACKOFF_MS = 30'000;
+// Minimum spacing between two retries, whichever panes they come from
+constexpr auto ADMISSION_INTERVAL_MS = 250;
+
+ReconnectScheduler &ReconnectScheduler::instance() {
+    static auto scheduler = new ReconnectScheduler(qApp);
+    return *scheduler;
+}
+
+ReconnectScheduler::ReconnectScheduler(QObject *parent):
+    QObject(parent),
+    _admission_timer(new QTimer(this))
+{
+    _clock.start();
+
+    _admission_timer->setSingleShot(true);
+    QObject::connect(_admission_timer, &QTimer::timeout, [=] { admit_next(); });
+
+    // Panes mostly fail because of the daemon: once its breaker closes
+    // again, nobody should keep sitting on a long backoff
+    QObject::connect(&NetworkService::instance(), &NetworkService::breaker_changed, this,
+        [=](QString host, NetworkService::BreakerState state) {
+            if (state == NetworkService::BreakerState::Closed && host == TwitchdAPI::base_url().host())
+                recovered();
+        }
+    );
+}
+
+void ReconnectScheduler::schedule(QObject *client, const QString &key, Retry retry) {
+    if (!_clients.contains(client)) {
+        QObject::connect(client, &QObject::destroyed, this, [=] {
+            _clients.remove(client);
+        });
+    }
+
+    auto & state = _clients[client];
+    state.key = key;
+    state.retry = retry;
+    state.failures += 1;
+    state.pending = true;
+
+    // Retrying is bound to fail while the daemon is known to be down
+    auto breaker_wait = NetworkService::instance().retry_in_ms(TwitchdAPI::base_url().host());
+    state.due_at_ms = _clock.elapsed() + std::max<qint64>(backoff_ms(state.failures), breaker_wait);
+
+    plan_admission();
+}
+
+void ReconnectScheduler::cancel(QObject *client) {
+    auto client_it = _clients.find(client);
+    if (client_it != _clients.end())
+        client_it->pending = false;
+}
+
+void ReconnectScheduler::succeeded(QObject *client) {
+    auto client_it = _clients.find(client);
+    if (client_it != _clients.end() && !client_it->pending)
+        client_it->failures = 0;
+}
+
+void ReconnectScheduler::recovered(const QString &key) {
+    auto now = _clock.elapsed();
+
+    for (auto & client: _clients) {
+        if (client.pending && (key.isEmpty() || client.key == key))
+            client.due_at_ms = now;
+    }
+
+    plan_admission();
+}
+
+// Full jitter over the upper half of the exponential delay
+int ReconnectScheduler::backoff_ms(int failures) const {
+    auto exponent = std::min(failures - 1, 16);
+    auto ceiling = static_cast<int>(std::min<qint64>(MAX_BACKOFF_MS, qint64(INITIAL_BACKOFF_MS) << exponent));
+
+    return ceiling / 2 + QRandomGenerator::global()->bounded(ceiling / 2 + 1);
+}
+
+void ReconnectScheduler::admit_next() {
+    auto now = _clock.elapsed();
+
+    auto next = _clients.end();
+    for (auto it = _clients.begin(); it != _clients.end(); ++it) {
+        if (it->pending && it->due_at_ms <= now && (next == _clients.end() || it->due_at_ms < next->due_at_ms))
+            next = it;
+    }
+
+    if (next != _clients.end()) {
+        next->pending = false;
+        _last_admission_ms = now;
+
+        // The retry can schedule again right away
+        auto retry = next->retry;
+        retry();
+    }
+
+    plan_admission();
+}
+
+void ReconnectScheduler::plan_admission() {
+    auto earliest = std::numeric_limits<qint64>::max();
+    for (auto & client: _clients) {
+        if (client.pending)
+            earliest = std::min(earliest, client.due_at_ms);
+    }
+
+    if (earliest == std::numeric_limits<qint64>::max()) {
+        _admission_timer->stop();
+        return;
+    }
+
+    if (_last_admission_ms >= 0)
+        earliest = std::max(earliest, _last_admission_ms + ADMISSION_INTERVAL_MS);
+
+    auto delay = std::max<qint64>(0, earliest - _clock.elapsed());
+    _admission_timer->start(static_cast<int>(delay));
+}
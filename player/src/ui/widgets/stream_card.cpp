@@ -1,10 +1,10 @@
 #include "ui/widgets/stream_card.hpp"
 #include "ui_stream_card.h"
 
-#include <QHBoxLayout>
+#include "api/images.hpp"
 
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QHBoxLayout>
+#include <QPointer>
 
 StreamCard::StreamCard(StreamData data, QWidget *parent):
     QWidget(parent),
@@ -43,19 +43,52 @@ StreamCard::StreamCard(StreamData data, QWidget *parent):
     _uptime_widget->show();
     _uptime_widget->move(_ui->preview->width() - _uptime_widget->width(), 0);
 
-    auto http_client = new QNetworkAccessManager(this);
-    http_client->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
-    auto preview_reply = http_client->get(QNetworkRequest(QUrl(data.preview)));
+    // Paint whatever we already have (possibly from a previous session), the
+    // refresh waits for the card to be on screen
+    auto preview_size = _ui->preview->minimumSize();
+    if (auto cached = ImageService::instance().cached(data.preview, preview_size))
+        _ui->preview->setPixmap(*cached);
+}
 
-    QObject::connect(preview_reply, &QNetworkReply::finished, [=] {
-        auto data = preview_reply->readAll();
-        _ui->preview->setPixmap(QPixmap::fromImage(QImage::fromData(data)));
-        preview_reply->deleteLater();
-    });
+// Downloads nobody is waiting for anymore are abandoned
+StreamCard::~StreamCard() {
+    if (_preview_fetch)
+        _preview_fetch->cancel();
 }
 
-StreamCard::~StreamCard() = default;
+QString StreamCard::channel() const {
+    return _data.channel.name;
+}
+
+void StreamCard::set_viewcount(uint32_t viewcount) {
+    _data.viewcount = viewcount;
+    _ui->viewerCount->setText(QString("%1 viewers").arg(viewcount));
+}
 
 void StreamCard::mousePressEvent(QMouseEvent *) {
     emit clicked(_data.channel.name);
 }
+
+// Cards scrolled out of the viewport are never painted, so their previews
+// do not compete with the ones actually visible
+void StreamCard::paintEvent(QPaintEvent *event) {
+    QWidget::paintEvent(event);
+
+    if (!_preview_fetch)
+        fetch_preview();
+}
+
+void StreamCard::fetch_preview() {
+    _preview_fetch = std::make_shared<Cancellable>();
+
+    // The card can be thrown away (new search, picker closed) before its
+    // preview arrives
+    QPointer<QLabel> preview = _ui->preview;
+
+    ImageService::instance()
+        .fetch(_data.preview, _ui->preview->minimumSize(), _preview_fetch)
+        .then([=](QPixmap pixmap) {
+            if (preview)
+                preview->setPixmap(pixmap);
+        });
+}
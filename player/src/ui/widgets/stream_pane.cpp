@@ -4,8 +4,11 @@
 #include "ui/widgets/stream_widget.hpp"
 #include "ui/widgets/video_widget.hpp"
 #include "ui/overlays/video_controls.hpp"
+#include "ui/overlays/video_details.hpp"
 #include "ui/utils/event_notifier.hpp"
 
+#include "api/stream_directory.hpp"
+
 #include "libvlc/bindings.hpp"
 
 #include "prelude/timer.hpp"
@@ -13,6 +16,7 @@
 #include <QHBoxLayout>
 #include <QPainter>
 #include <QApplication>
+#include <QPointer>
 
 constexpr auto border_width = 1;
 
@@ -21,12 +25,12 @@ static const std::initializer_list<QEvent::Type> FOCUS_INVALIDATING_EVENTS = {
     QEvent::KeyRelease
 };
 
-StreamPane::StreamPane(libvlc::Instance &video_ctx, QWidget *parent):
+StreamPane::StreamPane(libvlc::AsyncInstance video_ctx, StreamDirectory &directory, QWidget *parent):
     QWidget(parent),
     _video_ctx(video_ctx),
+    _directory(directory),
     _layout(new QHBoxLayout(this)),
-    _picker(std::make_unique<StreamPicker>(this)),
-    _stream(std::make_unique<StreamWidget>(video_ctx, this))
+    _picker(std::make_unique<StreamPicker>(directory, this))
 {
     auto notifier = new EventNotifier(FOCUS_INVALIDATING_EVENTS, this);
     window()->installEventFilter(notifier);
@@ -36,9 +40,29 @@ StreamPane::StreamPane(libvlc::Instance &video_ctx, QWidget *parent):
     });
 
     setup_picker();
-    setup_stream();
 
-    _stream->hide();
+    QPointer<StreamPane> self = this;
+    _video_ctx.then([=](std::shared_ptr<libvlc::Instance> instance) {
+        if (!self || !instance)
+            return;
+
+        _instance = instance;
+        create_stream();
+
+        if (_queued_play) {
+            auto [channel, quality] = *_queued_play;
+            _queued_play.reset();
+            play(channel, quality);
+        }
+    });
+
+    QObject::connect(&_directory, &StreamDirectory::viewcount_changed, this,
+        [=](QString channel, int viewers) {
+            if (_stream && channel == _viewcount_channel)
+                _stream->video()->details().set_viewcount(viewers);
+        }
+    );
+
     setLayout(_layout);
 
     _layout->addWidget(_picker.get());
@@ -50,9 +74,16 @@ StreamPane::StreamPane(libvlc::Instance &video_ctx, QWidget *parent):
     setAutoFillBackground(true);
 }
 
-StreamPane::~StreamPane() = default;
+StreamPane::~StreamPane() {
+    watch_viewcount({ });
+}
 
 void StreamPane::play(QString channel, QString quality) {
+    if (!_stream) {
+        _queued_play = std::make_pair(channel, quality);
+        return;
+    }
+
     _picker->hide();
 
     _layout->removeWidget(_picker.get());
@@ -61,6 +92,7 @@ void StreamPane::play(QString channel, QString quality) {
     _stream->setFocus();
     _stream->show();
     _stream->play(channel, quality);
+    watch_viewcount(channel);
 
     repaint();
 }
@@ -108,17 +140,24 @@ void StreamPane::setup_picker() {
     QObject::connect( _picker.get(), &StreamPicker::stream_picked, play_stream);
 }
 
+void StreamPane::create_stream() {
+    _stream = std::make_unique<StreamWidget>(*_instance, this);
+    _stream->hide();
+
+    setup_stream();
+}
+
 void StreamPane::setup_stream() {
     auto on_browse = [=] {
         // For some unknown reasons, the foreign widget doesn't get properly
         // released unless we schedule the removing for later...
         delayed(this, 250, [=] {
             _layout->removeWidget(_stream.get());
+            watch_viewcount({ });
 
-            _picker = std::make_unique<StreamPicker>(this);
-            _stream = std::make_unique<StreamWidget>(_video_ctx, this);
+            _picker = std::make_unique<StreamPicker>(_directory, this);
             setup_picker();
-            setup_stream();
+            create_stream();
 
             _layout->addWidget(_picker.get());
 
@@ -154,3 +193,16 @@ void StreamPane::setup_stream() {
         }
     );
 }
+
+void StreamPane::watch_viewcount(const QString &channel) {
+    if (channel == _viewcount_channel)
+        return;
+
+    if (!_viewcount_channel.isEmpty())
+        _directory.unwatch_viewcount(_viewcount_channel);
+
+    _viewcount_channel = channel;
+
+    if (!_viewcount_channel.isEmpty())
+        _directory.watch_viewcount(_viewcount_channel);
+}
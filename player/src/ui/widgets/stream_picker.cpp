@@ -4,41 +4,125 @@
 #include "ui/layouts/flow.hpp"
 #include "ui/widgets/stream_card.hpp"
 
-#include "api/oauth.hpp"
+#include "api/stream_directory.hpp"
+#include "api/token_manager.hpp"
+
+#include "prelude/timer.hpp"
 
 #include "constants.hpp"
 
 #include <QSettings>
+#include <QScrollBar>
+#include <QCompleter>
+#include <QStringListModel>
+
+constexpr auto SEARCH_DEBOUNCE_MS = 300;
+constexpr auto MAX_LOCAL_MATCHES = 16;
 
-StreamPicker::StreamPicker(QWidget *parent):
+StreamPicker::StreamPicker(StreamDirectory &directory, QWidget *parent):
     QWidget(parent),
     _ui(std::make_unique<Ui::StreamPicker>()),
     _channels_stream_presenter(new QWidget(this)),
-    _followed_stream_presenter(new QWidget(this))
+    _followed_stream_presenter(new QWidget(this)),
+    _directory(directory),
+    _suggestions(new QStringListModel(this))
 {
     _ui->setupUi(this);
 
+    // Suggestions are already ranked by the channel index, the completer
+    // must show them as they are
+    auto completer = new QCompleter(_suggestions, this);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    _ui->searchBox->setCompleter(completer);
+
     new FlowLayout(_channels_stream_presenter);
     _ui->channelsStreamArea->setWidget(_channels_stream_presenter);
     new FlowLayout(_followed_stream_presenter);
     _ui->followedStreamArea->setWidget(_followed_stream_presenter);
 
-    QSettings settings;
+    watch_scrolling(_ui->channelsStreamArea, _channels_stream_presenter);
+    watch_scrolling(_ui->followedStreamArea, _followed_stream_presenter);
 
-    auto access_token = settings
-        .value(constants::settings::oauth::ACCESS_TOKEN_KEY)
-        .toString();
+    QObject::connect(&_directory, &StreamDirectory::page_ready, this,
+        [=](QString key, int index, QList<StreamData> streams) {
+            for (auto & [container, feed]: _feeds) {
+                if (feed.key == key && feed.pages_presented == index) {
+                    feed.pages_presented += 1;
+                    present_streams(container, streams);
+                }
+            }
+        }
+    );
+
+    QObject::connect(&_directory, &StreamDirectory::listing_reset, this, [=](QString key) {
+        for (auto & [container, feed]: _feeds) {
+            if (feed.key == key) {
+                clear_streams(container);
+                feed.pages_presented = 0;
+                feed.channels_presented.clear();
+                load_next_page(container);
+            }
+        }
+    });
 
-    fetch_streams(_api.top_streams(), _channels_stream_presenter);
+    // Only the followed listing changes in place, cards beyond what has been
+    // presented come with their page
+    QObject::connect(&_directory, &StreamDirectory::stream_added, this,
+        [=](QString key, int position, StreamData stream) {
+            for (auto & [container, feed]: _feeds) {
+                auto layout = static_cast<FlowLayout *>(container->layout());
+
+                if (feed.key != key || position > layout->count())
+                    continue;
+                if (feed.channels_presented.contains(stream.channel.name))
+                    continue;
+
+                feed.channels_presented.insert(stream.channel.name);
+                layout->insertWidget(position, make_card(stream, container));
+            }
+        }
+    );
+
+    QObject::connect(&_directory, &StreamDirectory::stream_removed, this,
+        [=](QString key, QString channel) {
+            for (auto & [container, feed]: _feeds) {
+                if (feed.key != key || !feed.channels_presented.remove(channel))
+                    continue;
+
+                for (auto card: container->findChildren<StreamCard *>()) {
+                    if (card->channel() == channel) {
+                        container->layout()->removeWidget(card);
+                        card->deleteLater();
+                    }
+                }
+            }
+        }
+    );
+
+    auto access_token = TokenManager::instance().access_token();
+
+    show_feed(_channels_stream_presenter, StreamDirectory::top_key());
 
     if (!access_token.isEmpty())
-        fetch_streams(_api.followed_streams(access_token), _followed_stream_presenter);
+        show_feed(_followed_stream_presenter, StreamDirectory::followed_key());
+
+    auto search = debounced(this, SEARCH_DEBOUNCE_MS, [=] {
+        auto query = _ui->searchBox->text();
 
-    QObject::connect(_ui->searchBox, &QLineEdit::textChanged, [this](auto query) {
         if (query.isEmpty())
-            fetch_streams(_api.top_streams(), _channels_stream_presenter);
+            show_feed(_channels_stream_presenter, StreamDirectory::top_key());
         else
-            fetch_streams(_api.stream_search(query), _channels_stream_presenter);
+            show_feed(_channels_stream_presenter, StreamDirectory::search_key(query), true);
+    });
+
+    QObject::connect(_ui->searchBox, &QLineEdit::textChanged, [=](auto query) {
+        // Whatever is in flight is already stale: stop waiting for it right
+        // away rather than when the debounced search replaces it
+        reset_feed(_channels_stream_presenter);
+        // Known channels show up without waiting for the server
+        present_local_matches(query);
+        search();
     });
 
     QObject::connect(_ui->searchBox, &QLineEdit::returnPressed, [this] {
@@ -46,7 +130,10 @@ StreamPicker::StreamPicker(QWidget *parent):
     });
 }
 
-StreamPicker::~StreamPicker() = default;
+StreamPicker::~StreamPicker() {
+    for (auto & [container, _feed]: _feeds)
+        reset_feed(container);
+}
 
 void StreamPicker::focusInEvent(QFocusEvent *event) {
     QWidget::focusInEvent(event);
@@ -61,40 +148,144 @@ void StreamPicker::channel_picked(QString channel) {
         .value(KEY_LAST_QUALITY_FOR(channel))
         .toString();
 
+    _directory.channels().insert(channel, ChannelIndex::Source::Watched);
+
     emit stream_picked(channel, quality);
 }
 
-void StreamPicker::fetch_streams(TwitchAPI::streams_response_t query, QWidget *container) {
-    auto & current_query = current_queries[container];
+void StreamPicker::watch_scrolling(QScrollArea *area, QWidget *container) {
+    auto scroll_bar = area->verticalScrollBar();
 
-    if (current_query)
-        current_query->cancel();
+    // Prefetch the next page as soon as less than a viewport worth of cards
+    // remains below the visible area. Also triggers when the content is too
+    // short to be scrollable at all
+    auto check_remaining = [=] {
+        auto remaining = scroll_bar->maximum() - scroll_bar->value();
+        if (remaining <= area->viewport()->height())
+            load_next_page(container);
+    };
 
-    auto [token, cquery] = make_cancellable(query);
+    QObject::connect(scroll_bar, &QScrollBar::valueChanged, check_remaining);
+    QObject::connect(scroll_bar, &QScrollBar::rangeChanged, check_remaining);
+}
 
-    auto present_streams_on_container = [=](QList<StreamData> stream_data) {
-        present_streams(container, stream_data);
-    };
+void StreamPicker::show_feed(QWidget *container, QString key, bool merge) {
+    reset_feed(container);
 
-    cquery.then(present_streams_on_container);
+    auto & feed = _feeds[container];
+    feed.key = key;
+    feed.pages_presented = 0;
 
-    current_query = token;
+    if (!merge) {
+        clear_streams(container);
+        feed.channels_presented.clear();
+    }
+
+    _directory.watch(key);
+
+    load_next_page(container);
 }
 
-void StreamPicker::present_streams(QWidget *container, QList<StreamData> stream_data) {
+// Stops following the directory, whatever is presented stays as is
+void StreamPicker::reset_feed(QWidget *container) {
+    auto & feed = _feeds[container];
+
+    if (!feed.key.isEmpty())
+        _directory.unwatch(feed.key);
+
+    feed.key.clear();
+}
+
+void StreamPicker::load_next_page(QWidget *container) {
+    auto & feed = _feeds[container];
+
+    if (feed.key.isEmpty())
+        return;
+
+    auto & pages = _directory.pages(feed.key);
+
+    if (feed.pages_presented < pages.size()) {
+        auto page = pages[feed.pages_presented];
+        feed.pages_presented += 1;
+        present_streams(container, page);
+    }
+    else
+        _directory.request_page(feed.key, feed.pages_presented);
+}
+
+// Channels seen live recently get a card right away, the server results are
+// merged in after them. Every match is suggested as a completion
+void StreamPicker::present_local_matches(const QString &query) {
+    auto container = _channels_stream_presenter;
+    auto matches = _directory.channels().search(query, MAX_LOCAL_MATCHES);
+
+    clear_streams(container);
+    _feeds[container].channels_presented.clear();
+
+    QStringList names;
+    QList<StreamData> live_streams;
+    for (auto & match: matches) {
+        names << match.name;
+        if (match.stream)
+            live_streams << *match.stream;
+    }
+
+    _suggestions->setStringList(names);
+    present_streams(container, live_streams);
+}
+
+void StreamPicker::clear_streams(QWidget *container) {
     auto layout = container->layout();
 
     QLayoutItem *item;
     while ((item = layout->takeAt(0)) != nullptr) {
+        // Viewer counts are released right away, before the cards replacing
+        // these ones watch theirs
+        auto card = qobject_cast<StreamCard *>(item->widget());
+        if (card && QObject::disconnect(card, &QObject::destroyed, &_directory, nullptr))
+            _directory.unwatch_viewcount(card->channel());
+
         item->widget()->deleteLater();
         delete item;
     }
+}
+
+void StreamPicker::present_streams(QWidget *container, QList<StreamData> stream_data) {
+    auto layout = container->layout();
+    auto & presented = _feeds[container].channels_presented;
 
     for (auto data: stream_data) {
-        auto stream_card = new StreamCard(data, container);
-        layout->addWidget(stream_card);
-        QObject::connect(stream_card, &StreamCard::clicked, [this](auto channel) {
-            channel_picked(channel);
+        // Offset based pages shift while the directory changes, which can
+        // repeat a stream across two consecutive pages
+        if (presented.contains(data.channel.name))
+            continue;
+        presented.insert(data.channel.name);
+
+        layout->addWidget(make_card(data, container));
+    }
+}
+
+StreamCard *StreamPicker::make_card(const StreamData &data, QWidget *container) {
+    auto stream_card = new StreamCard(data, container);
+
+    QObject::connect(stream_card, &StreamCard::clicked, [this](auto channel) {
+        channel_picked(channel);
+    });
+
+    auto channel = data.channel.name;
+    auto directory = &_directory;
+
+    if (directory->watch_viewcount(channel, true)) {
+        QObject::connect(stream_card, &QObject::destroyed, directory, [=] {
+            directory->unwatch_viewcount(channel);
         });
     }
+    QObject::connect(directory, &StreamDirectory::viewcount_changed, stream_card,
+        [=](QString updated_channel, int viewers) {
+            if (updated_channel == channel)
+                stream_card->set_viewcount(static_cast<uint32_t>(viewers));
+        }
+    );
+
+    return stream_card;
 }
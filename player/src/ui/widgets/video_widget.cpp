@@ -3,10 +3,19 @@
 #include "ui/overlays/video_controls.hpp"
 #include "ui/overlays/video_details.hpp"
 #include "ui/utils/event_notifier.hpp"
+#include "ui/utils/latency_tracker.hpp"
+#include "ui/utils/playback_monitor.hpp"
+#include "ui/utils/reconnect_scheduler.hpp"
 #include "ui/native/capabilities.hpp"
 
 #include "libvlc/event_watcher.hpp"
 
+#include "api/metrics.hpp"
+#include "api/network.hpp"
+#include "api/stream_prewarmer.hpp"
+
+#include "process/daemon_control.hpp"
+
 #include "prelude/variant.hpp"
 #include "prelude/timer.hpp"
 
@@ -17,6 +26,7 @@
 #include <QMouseEvent>
 #include <QShortcut>
 #include <QSettings>
+#include <QPointer>
 
 static auto quality_names(const StreamIndex & index) {
     QStringList qualities;
@@ -55,7 +65,8 @@ VideoWidget::VideoWidget(libvlc::Instance &instance, QWidget *parent):
     _details(new VideoDetails(this)),
     _controls(new VideoControls(this)),
     _event_watcher(new VLCEventWatcher(_media_player, this)),
-    _retry_timer(new QTimer(this))
+    _latency(new LatencyTracker(this)),
+    _health(new PlaybackMonitor(_media_player, this))
 {
     using namespace constants::settings;
 
@@ -95,77 +106,125 @@ VideoWidget::VideoWidget(libvlc::Instance &instance, QWidget *parent):
         activateWindow();
     });
 
-    _retry_timer->setSingleShot(true);
-    _retry_timer->setInterval(1000);
-    QObject::connect(_retry_timer, &QTimer::timeout, [=] {
-        play(_current_channel, _current_quality);
-        _retry_timer->setInterval(_retry_timer->interval() * 2);
+    QObject::connect(_latency, &LatencyTracker::latency_changed, [=](double delay_ms) {
+        _controls->set_delay(delay_ms / 1000.f);
+        _controls->set_delay_summary(_latency->summary());
     });
 
+    // libvlc keeps going on a stalled stream: reconnect without waiting for it
+    QObject::connect(_health, &PlaybackMonitor::stalled, [=](QString reason) {
+        ApiMetrics::instance().record_playback_event(_current_channel, reason);
+        _details->show_state(QString("%1, reconnecting...").arg(reason));
+        schedule_retry();
+    });
+
+    auto & network = NetworkService::instance();
+
+    QObject::connect(&network, &NetworkService::breaker_changed, this,
+        [=](QString host, NetworkService::BreakerState state) {
+            if (host != TwitchdAPI::base_url().host())
+                return;
+
+            if (state == NetworkService::BreakerState::Open) {
+                _daemon_unreachable_shown = true;
+                _details->show_state("Daemon unreachable, waiting...");
+            }
+            else if (state == NetworkService::BreakerState::Closed && _daemon_unreachable_shown) {
+                _daemon_unreachable_shown = false;
+                _details->show_state("Daemon back");
+            }
+        }
+    );
+
     QObject::connect(_event_watcher, &VLCEventWatcher::new_event, [=](auto event) {
         using namespace libvlc::events;
 
         auto set_buffering = [=](bool on) { _details->set_buffering(on); };
-        auto schedule_refresh = [=] { _retry_timer->start(); };
+        auto playing = [=](int64_t time) {
+            _latency->sample(time);
+            ReconnectScheduler::instance().succeeded(this);
+        };
 
         match(event,
             [=](Opening)          { set_buffering(true); },
-            [=](Playing)          {
-                if (!_current_metadata) {
-                    _api.metadata(_current_channel, _current_quality, _current_meta_key)
-                        .then([=](SegmentMetadata metadata) {
-                            _current_metadata = metadata;
-                        });
-                }
-            },
-            [=](TimeChanged c)    {
-                if (_current_metadata) {
-                    auto now = QDateTime::currentMSecsSinceEpoch();
-
-                    auto delay_ms = now - _current_metadata->transc_r
-                                        - c.new_time
-                                        // The website shows aditional delay
-                                        // Noticed it to be around +1s
-                                        + 1'000;
-
-                    if (delay_ms < 0 || delay_ms > 60'000)
-                        return ;
-
-                    _controls->set_delay(delay_ms / 1000.f);
-                }
-            },
+            [=](TimeChanged c)    { playing(c.new_time); },
             [=](Buffering b)      { set_buffering(b.cache_percent != 100.f); },
-            [=](EndReached)       { schedule_refresh(); },
-            [=](Stopped)          { schedule_refresh(); },
-            [=](EncounteredError) { schedule_refresh(); },
+            [=](EndReached)       { schedule_retry(); },
+            [=](Stopped)          { schedule_retry(); },
+            [=](EncounteredError) { schedule_retry(); },
             [=](auto)             { }
         );
     });
 }
 
-VideoWidget::~VideoWidget() = default;
+// The monitor samples the media player from a worker thread, it has to be
+// gone before the player is
+VideoWidget::~VideoWidget() {
+    delete _health;
+}
 
 void VideoWidget::play(QString channel, QString quality) {
     _current_channel = channel;
     _current_quality = quality;
-    _current_meta_key = generate_meta_key();
-    _current_metadata.reset();
 
-    auto location = TwitchdAPI::playback_url(channel, quality, _current_meta_key);
+    // Whatever was scheduled is superseded by this attempt
+    ReconnectScheduler::instance().cancel(this);
+
+    // Still starting: the latest channel and quality get played once it is
+    // ready
+    auto daemon_ready = daemon_control::ready();
+    if (daemon_ready.isPending()) {
+        _details->set_channel(channel);
+        _details->show();
+        _details->show_state("Starting the daemon...");
+        _details->set_buffering(true);
+
+        if (!_waiting_for_daemon) {
+            _waiting_for_daemon = true;
+
+            QPointer<VideoWidget> self = this;
+            daemon_ready.then([=] {
+                if (!self)
+                    return;
+
+                _waiting_for_daemon = false;
+                play(_current_channel, _current_quality);
+            });
+        }
 
-    _media.emplace(_instance, location.toStdString().c_str());
-    _media_player.set_media(*_media);
-    _media_player.play();
+        return;
+    }
+
+    auto meta_key = generate_meta_key();
+    _meta_key = meta_key;
+
+    QPointer<VideoWidget> self = this;
+    TwitchdAPI::playback_url(channel, quality, meta_key)
+        .then([=](QString location) {
+            // Superseded by another attempt while the token was refreshed
+            if (!self || _meta_key != meta_key)
+                return;
+
+            _media.emplace(_instance, location.toStdString().c_str());
+            _media_player.set_media(*_media);
+            _media_player.play();
+            _latency->track(channel, quality, meta_key);
+            _health->start();
+        });
 
     _details->set_channel(channel);
     _controls->clear_qualities();
 
-    _api.stream_index(channel).then([=](StreamIndex index) {
+    auto show_qualities = [=](StreamIndex index) {
         auto qualities = quality_names(index);
         _controls->clear_qualities();
         _controls->set_qualities(quality, qualities);
-        _retry_timer->setInterval(1000);
-    });
+    };
+
+    if (auto index = StreamPrewarmer::instance().stream_index(channel))
+        show_qualities(*index);
+    else
+        _api.stream_index(channel).then(show_qualities);
 
     _details->show();
 
@@ -230,6 +289,23 @@ VideoControls & VideoWidget::controls() const {
     return *_controls;
 }
 
+VideoDetails & VideoWidget::details() const {
+    return *_details;
+}
+
+LatencyTracker & VideoWidget::latency() const {
+    return *_latency;
+}
+
+void VideoWidget::schedule_retry() {
+    _latency->stop();
+    _health->stop();
+
+    ReconnectScheduler::instance().schedule(this, _current_channel, [=] {
+        play(_current_channel, _current_quality);
+    });
+}
+
 void VideoWidget::update_overlay_position() {
     auto top_left = mapToGlobal(pos()) - pos();
     auto bottom_left = top_left + QPoint(0, height());
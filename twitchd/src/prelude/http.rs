@@ -65,6 +65,18 @@ pub fn streaming_response() -> (ResponseSink, Response) {
     (sink, response)
 }
 
+/// Encodes a value as a single server-sent event
+pub fn sse_event(value: &impl serde::Serialize) -> Result<Vec<u8>, serde_json::Error> {
+    let json = serde_json::to_vec(value)?;
+
+    let mut event = Vec::with_capacity(json.len() + 8);
+    event.extend_from_slice(b"data: ");
+    event.extend(json);
+    event.extend_from_slice(b"\n\n");
+
+    Ok(event)
+}
+
 #[derive(thiserror::Error, Debug)]
 pub enum HttpError {
     #[error("Network error: {0}")]
@@ -72,3 +84,23 @@ pub enum HttpError {
     #[error("Unexpected HTTP status: {0}")]
     BadStatus(hyper::StatusCode),
 }
+
+#[cfg(test)]
+mod tests {
+    #[test]
+    fn sse_event_is_a_single_data_line() {
+        let event = super::sse_event(&serde_json::json!({ "sink_offset": 2.5 }))
+            .expect("Encoding error");
+
+        assert_eq!(event, b"data: {\"sink_offset\":2.5}\n\n".to_vec());
+    }
+
+    #[test]
+    fn sse_event_escapes_newlines() {
+        let event = super::sse_event(&"multi\nline").expect("Encoding error");
+        let text = String::from_utf8(event).expect("Invalid UTF-8");
+
+        assert_eq!(text.matches('\n').count(), 2);
+        assert!(text.ends_with("\n\n"));
+    }
+}
@@ -4,7 +4,7 @@ use crate::twitch::utils::find_playlist;
 
 use super::state::{State, index_cache::IndexError};
 
-const DAEMON_VERSION: &str = "1.5.0";
+const DAEMON_VERSION: &str = "1.6.0";
 
 pub struct TwitchdApi<'st> {
     state: &'st State
@@ -29,6 +29,7 @@ impl TwitchdApi<'_> {
             (&Method::GET, "/stream_index")  => self.get_stream_index(params).await,
             (&Method::GET, "/play")          => self.get_video_stream(params).await,
             (&Method::GET, "/meta")          => self.get_metadata(params).await,
+            (&Method::GET, "/meta_stream")   => self.get_metadata_stream(params).await,
             // Utilities
             (&Method::GET,  "/version")      => Ok(Self::get_version()),
             (&Method::POST, "/quit")         => Ok(self.post_quit().await),
@@ -79,6 +80,23 @@ impl TwitchdApi<'_> {
         Ok(json_response(metadata))
     }
 
+    async fn get_metadata_stream(&self, params: ApiParams<'_>) -> ApiResponse {
+        let stream = params.get_stream()?;
+        let key = params.get("key")?;
+
+        let (sink, mut response) = streaming_response();
+        response.headers_mut().insert(
+            header::CONTENT_TYPE,
+            header::HeaderValue::from_static(mime::TEXT_EVENT_STREAM.as_ref()),
+        );
+
+        self.state.player_pool.subscribe_metadata(&stream, sink, key.to_owned())
+            .await
+            .ok_or(ApiError::NotFound)?;
+
+        Ok(response)
+    }
+
     fn get_version() -> Response {
         Response::new(DAEMON_VERSION.into())
     }
@@ -1,14 +1,11 @@
-use super::stream_player::{MetaKey, PlayerSink, StreamPlayer};
+use super::stream_player::{MetaKey, PlayerSink, SinkMetadata, StreamPlayer};
 use crate::{
     options::Options,
     prelude::{
         http::{http_client, HttpsClient},
         runtime,
     },
-    twitch::{
-        mpeg_ts::SegmentMetadata,
-        types::{PlaylistInfo, Stream},
-    },
+    twitch::types::{PlaylistInfo, Stream},
 };
 
 use std::{
@@ -41,7 +38,7 @@ impl PlayerPool {
         &self,
         stream: &Stream,
         meta_key: &MetaKey,
-    ) -> Option<SegmentMetadata> {
+    ) -> Option<SinkMetadata> {
         self.players
             .lock()
             .await
@@ -49,6 +46,22 @@ impl PlayerPool {
             .get_metadata(meta_key)
             .await
     }
+
+    pub async fn subscribe_metadata(
+        &self,
+        stream: &Stream,
+        sink: PlayerSink,
+        meta_key: MetaKey,
+    ) -> Option<()> {
+        self.players
+            .lock()
+            .await
+            .get(stream)?
+            .subscribe_metadata(sink, meta_key)
+            .await;
+
+        Some(())
+    }
 }
 
 pub struct Entry<'pool> {
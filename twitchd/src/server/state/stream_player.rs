@@ -19,11 +19,36 @@ type RawVideoData = Vec<u8>;
 pub type PlayerSink = ResponseSink;
 pub type MetaKey = String;
 
+/// Metadata of the most recent segment sent to a sink, along with the
+/// position at which that segment starts in the sink's own stream
+#[derive(Debug, Clone, serde::Serialize)]
+pub struct SinkMetadata {
+    #[serde(flatten)]
+    segment: SegmentMetadata,
+    /// In seconds, relative to the first segment sent to the sink
+    sink_offset: f64,
+}
+
 pub struct StreamPlayer {
     opts: Options,
     client: HttpsClient,
     sink_queue: Arc<Mutex<Vec<(MetaKey, PlayerSink)>>>,
-    indexed_metadata: Arc<Mutex<HashMap<MetaKey, SegmentMetadata>>>,
+    indexed_metadata: Arc<Mutex<HashMap<MetaKey, SinkMetadata>>>,
+    metadata_subscribers: Arc<Mutex<Vec<MetadataSubscriber>>>,
+}
+
+struct MetadataSubscriber {
+    key: MetaKey,
+    sender: mpsc::Sender<SinkMetadata>,
+    // Whether the sink identified by `key` was ever seen alive
+    attached: bool,
+}
+
+struct LiveSink {
+    key: MetaKey,
+    // Stream offset of the first segment that had metadata
+    origin: Option<f64>,
+    sender: mpsc::Sender<RawVideoData>,
 }
 
 impl StreamPlayer {
@@ -33,6 +58,7 @@ impl StreamPlayer {
             client,
             sink_queue: Default::default(),
             indexed_metadata: Default::default(),
+            metadata_subscribers: Default::default(),
         }
     }
 
@@ -43,6 +69,7 @@ impl StreamPlayer {
         let client = self.client.clone();
         let sink_queue = Arc::clone(&self.sink_queue);
         let indexed_metadata = Arc::clone(&self.indexed_metadata);
+        let metadata_subscribers = Arc::clone(&self.metadata_subscribers);
 
         async move {
             let mut last_active = Instant::now();
@@ -67,23 +94,35 @@ impl StreamPlayer {
                 };
 
                 if let SegmentChunk::Head(data) = &segment_chunk {
-                    if !sink_queue.lock().await.is_empty() {
-                        let opt_metadata = extract_metadata(&data);
-
-                        let mut sink_queue = sink_queue.lock().await;
-                        let mut indexed_metadata = indexed_metadata.lock().await;
+                    let opt_metadata = extract_metadata(&data);
 
-                        for (key, sink) in sink_queue.drain(..) {
-                            if let Some(metadata) = &opt_metadata {
-                                indexed_metadata.insert(key, metadata.clone());
-                            }
+                    let mut sink_queue = sink_queue.lock().await;
+                    for (key, sink) in sink_queue.drain(..) {
+                        let (sender, stream) = mpsc::channel(16);
+                        senders.push(LiveSink { key, origin: None, sender });
 
-                            let (sender, stream) = mpsc::channel(16);
-                            senders.push(sender);
+                        runtime::spawn(drain_stream(stream, sink, opts.player_max_sink_buffer_size));
+                    }
 
-                            runtime::spawn(drain_stream(stream, sink, opts.player_max_sink_buffer_size));
+                    // Refreshed on every segment so that clients can keep
+                    // track of their latency for as long as they play
+                    let mut indexed_metadata = indexed_metadata.lock().await;
+                    if let Some(metadata) = &opt_metadata {
+                        for sink in senders.iter_mut() {
+                            let origin = *sink.origin.get_or_insert(metadata.stream_offset());
+
+                            indexed_metadata.insert(sink.key.clone(), SinkMetadata {
+                                segment: metadata.clone(),
+                                sink_offset: metadata.stream_offset() - origin,
+                            });
                         }
                     }
+                    indexed_metadata.retain(|key, _| senders.iter().any(|sink| &sink.key == key));
+
+                    if opt_metadata.is_some() {
+                        let mut subscribers = metadata_subscribers.lock().await;
+                        push_metadata(&mut subscribers, &indexed_metadata);
+                    }
                 }
 
                 fanout_and_filter(&mut senders, segment_chunk.into_data());
@@ -104,9 +143,24 @@ impl StreamPlayer {
         self.sink_queue.lock().await.push((meta_key, sink))
     }
 
-    pub async fn get_metadata(&self, meta_key: &MetaKey) -> Option<SegmentMetadata> {
+    pub async fn get_metadata(&self, meta_key: &MetaKey) -> Option<SinkMetadata> {
         self.indexed_metadata.lock().await.get(meta_key).cloned()
     }
+
+    /// Streams the metadata of every segment sent to the sink identified by
+    /// `meta_key` as server-sent events, starting with the current one if any
+    pub async fn subscribe_metadata(&self, sink: ResponseSink, meta_key: MetaKey) {
+        let (mut sender, events) = mpsc::channel(4);
+
+        let attached = match self.get_metadata(&meta_key).await {
+            Some(metadata) => { let _ = sender.try_send(metadata); true },
+            None => false,
+        };
+
+        self.metadata_subscribers.lock().await.push(MetadataSubscriber { key: meta_key, sender, attached });
+
+        runtime::spawn(forward_metadata(events, sink));
+    }
 }
 
 fn segment_stream(client: HttpsClient, playlist_info: PlaylistInfo, fetch_interval: Duration, video_chunks_size: usize)
@@ -202,23 +256,85 @@ fn segment_picker() -> impl FnMut(Playlist) -> Option<Segment> {
 
 // Helper function that pretty much combines a `drain_filter` algorithm
 // with a fan out style data dispatching
-fn fanout_and_filter(senders: &mut Vec<mpsc::Sender<RawVideoData>>, data: RawVideoData) {
+fn fanout_and_filter(senders: &mut Vec<LiveSink>, data: RawVideoData) {
     if senders.is_empty() { return }
 
     let mut i = 0;
     // Fan the input data out to every client except the last one
     while i < senders.len() - 1 {
-        match senders[i].try_send(data.clone()) {
+        match senders[i].sender.try_send(data.clone()) {
             Ok(_)  => { i += 1; },
             Err(_) => { let _ = senders.remove(i); }
         }
     }
     // The last sink can save us a clone on the input data
-    if let Err(_) = senders[i].try_send(data) {
+    if let Err(_) = senders[i].sender.try_send(data) {
         let _ = senders.remove(i);
     }
 }
 
+// Subscribers that went away (or that cannot keep up with one event per
+// segment) are dropped, they can reconnect to get a fresh snapshot.
+// So are the ones whose sink is gone: `indexed_metadata` only holds live sinks
+fn push_metadata(
+    subscribers: &mut Vec<MetadataSubscriber>,
+    indexed_metadata: &HashMap<MetaKey, SinkMetadata>,
+) {
+    let mut i = 0;
+    while i < subscribers.len() {
+        let subscriber = &mut subscribers[i];
+
+        let alive = match indexed_metadata.get(&subscriber.key) {
+            Some(metadata) => {
+                subscriber.attached = true;
+                subscriber.sender.try_send(metadata.clone()).is_ok()
+            },
+            // Sinks may be queued after their subscriber, keep waiting for those
+            None => !subscriber.attached && !subscriber.sender.is_closed(),
+        };
+
+        if alive { i += 1; } else { let _ = subscribers.swap_remove(i); }
+    }
+}
+
+const METADATA_KEEP_ALIVE_INTERVAL: Duration = Duration::from_secs(15);
+
+enum MetadataEvent {
+    Segment(SinkMetadata),
+    KeepAlive,
+    Closed,
+}
+
+// Keep-alive comments are interleaved with the events so that a client that
+// went away is noticed even while its sink gets no new segment
+async fn forward_metadata<S>(events: S, mut sink: ResponseSink)
+where
+    S: Stream<Item = SinkMetadata> + Unpin
+{
+    let events = events
+        .map(MetadataEvent::Segment)
+        .chain(stream::once(future::ready(MetadataEvent::Closed)));
+    let keep_alives = interval(METADATA_KEEP_ALIVE_INTERVAL)
+        .map(|_| MetadataEvent::KeepAlive);
+
+    let mut events = stream::select(events, keep_alives);
+
+    while let Some(event) = events.next().await {
+        let data = match event {
+            MetadataEvent::Segment(metadata) => match sse_event(&metadata) {
+                Ok(data) => data,
+                Err(_) => continue,
+            },
+            MetadataEvent::KeepAlive => b": keep-alive\n\n".to_vec(),
+            MetadataEvent::Closed => return,
+        };
+
+        if sink.send_data(data.into()).await.is_err() {
+            return
+        }
+    }
+}
+
 async fn drain_stream<S>(mut video_stream: S, mut sink: PlayerSink, max_buffer_size: usize)
 where
     S: Stream<Item = RawVideoData> + Unpin
@@ -265,3 +381,56 @@ pub enum StreamPlayerError {
     TooLongToFetch,
     EmptySegment
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sink_metadata() -> SinkMetadata {
+        let mpeg_data = include_bytes!("../../../test_samples/mpeg_ts/encoded_160p.ts");
+        let segment = extract_metadata(mpeg_data).expect("No metadata in sample");
+
+        SinkMetadata { segment, sink_offset: 0.0 }
+    }
+
+    fn subscriber(key: &str, attached: bool) -> (MetadataSubscriber, mpsc::Receiver<SinkMetadata>) {
+        let (sender, events) = mpsc::channel(4);
+        (MetadataSubscriber { key: key.to_owned(), sender, attached }, events)
+    }
+
+    #[test]
+    fn push_metadata_feeds_live_sinks() {
+        let (live, mut events) = subscriber("live", false);
+        let mut subscribers = vec![live];
+        let indexed_metadata = vec![("live".to_owned(), sink_metadata())].into_iter().collect();
+
+        push_metadata(&mut subscribers, &indexed_metadata);
+
+        assert_eq!(subscribers.len(), 1);
+        assert!(subscribers[0].attached);
+        assert!(events.try_next().expect("No event sent").is_some());
+    }
+
+    #[test]
+    fn push_metadata_drops_subscribers_of_gone_sinks() {
+        let (gone, _gone_events) = subscriber("gone", true);
+        let (pending, _pending_events) = subscriber("pending", false);
+        let mut subscribers = vec![gone, pending];
+
+        push_metadata(&mut subscribers, &HashMap::new());
+
+        assert_eq!(subscribers.len(), 1);
+        assert_eq!(subscribers[0].key, "pending");
+    }
+
+    #[test]
+    fn push_metadata_drops_closed_subscribers() {
+        let (pending, pending_events) = subscriber("pending", false);
+        let mut subscribers = vec![pending];
+        drop(pending_events);
+
+        push_metadata(&mut subscribers, &HashMap::new());
+
+        assert!(subscribers.is_empty());
+    }
+}
@@ -12,6 +12,12 @@ pub struct SegmentMetadata {
     stream_loudness: Option<f32>,
 }
 
+impl SegmentMetadata {
+    pub fn stream_offset(&self) -> f64 {
+        self.stream_offset
+    }
+}
+
 const MPEG_TS_SECTION_LENGTH: usize = 188;
 // The metadata packet seems to always be the 3rd one
 const FIRST_PES_METADATA_OFFSET: usize = MPEG_TS_SECTION_LENGTH * 3;